@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+#ifndef MYCOMPONENTS_KEYBOARD_INC_KEYBOARD_HPP_
+#define MYCOMPONENTS_KEYBOARD_INC_KEYBOARD_HPP_
+
+/*
+ * C++ 封装（仅头文件，需要 C++17）
+ *
+ * 键位表是 constexpr 对象：重复的 key_id、重复的硬件位置、越界的矩阵/GPIO 坐标以及当前配置不支持的后端
+ * 都在编译期由 static_assert 报出，而不是等到 keyboard_register_key() 运行时返回错误码。
+ * 事件处理器是模板参数（lambda 或函数对象），C 回调经一个静态跳板直接调用它，没有堆分配和 std::function。
+ *
+ *     static constexpr auto kmap = kb::make_keymap(
+ *         kb::matrix_key(0x0011, "K_1", 0, 0),
+ *         kb::matrix_key(0x0012, "K_2", 0, 1));
+ *
+ *     static auto kbd = kb::make_keyboard<kmap>([](uint16_t id, kb_event_t evt) { ... });
+ *     kbd.init(ops);
+ *     kbd.poll(10);
+ */
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error "keyboard.hpp requires C++17"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+extern "C" {
+#include "keyboard_driver.h"
+}
+
+/*
+ * 控制块由 keyboard_config.h 定长分配。置 1 后要求 KB_MAX_KEYS 等于键位表大小、
+ * KEYBOARD_POOL_SIZE 等于 kb::pool_size_for<N>，否则编译失败，保证存储正好容纳键位表
+ */
+#ifndef KB_EXACT_KEYMAP_SIZE
+#define KB_EXACT_KEYMAP_SIZE 0
+#endif
+
+namespace kb
+{
+
+/* 键位表中的一个按键；a/b 为 GPIO 引脚或矩阵行列，code 为自定义/输入捕获后端的编码 */
+struct key_def
+{
+    const char *name;
+    uint16_t id;
+    uint8_t backend;
+    uint8_t a;
+    uint8_t b;
+    uint16_t code;
+};
+
+constexpr key_def gpio_key(uint16_t id, const char *name, uint8_t pin)
+{
+    return key_def{name, id, (uint8_t)KB_BACKEND_GPIO, pin, 0u, 0u};
+}
+
+constexpr key_def matrix_key(uint16_t id, const char *name, uint8_t row, uint8_t col)
+{
+    return key_def{name, id, (uint8_t)KB_BACKEND_MATRIX, row, col, 0u};
+}
+
+constexpr key_def custom_key(uint16_t id, const char *name, uint16_t code)
+{
+    return key_def{name, id, (uint8_t)KB_BACKEND_CUSTOM, 0u, 0u, code};
+}
+
+constexpr key_def capture_key(uint16_t id, const char *name, uint16_t channel)
+{
+    return key_def{name, id, (uint8_t)KB_BACKEND_CAPTURE, 0u, 0u, channel};
+}
+
+/* 内存池中每个按键占用的字节数；KEYBOARD_POOL_SIZE 取 pool_size_for<N> 时正好容纳 N 个按键 */
+constexpr std::size_t pool_stride = MPOOL_ALIGN_UP(sizeof(keyboard_que_t) + sizeof(mpool_node_t));
+
+template <std::size_t N>
+constexpr std::size_t pool_size_for = N * pool_stride;
+
+template <std::size_t N>
+struct keymap
+{
+    key_def key[N];
+
+    static constexpr std::size_t size()
+    {
+        return N;
+    }
+
+    /* 与 kb_hw_equal() 相同：同一后端下比较各自的硬件位置 */
+    static constexpr bool same_hw(const key_def &x, const key_def &y)
+    {
+        if (x.backend != y.backend)
+        {
+            return false;
+        }
+        if (x.backend == KB_BACKEND_GPIO)
+        {
+            return x.a == y.a;
+        }
+        if (x.backend == KB_BACKEND_MATRIX)
+        {
+            return x.a == y.a && x.b == y.b;
+        }
+        return x.code == y.code;
+    }
+
+    /* 非混合模式只允许 KB_BACKEND_MODE；混合模式下输入捕获之外的后端都可以 */
+    constexpr bool backends_ok() const
+    {
+        for (std::size_t i = 0u; i < N; i++)
+        {
+            if (key[i].backend != KB_BACKEND_MODE &&
+                !(KB_USING_HYBRID && key[i].backend != KB_BACKEND_CAPTURE))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr bool names_ok() const
+    {
+        for (std::size_t i = 0u; i < N; i++)
+        {
+            if (key[i].name == nullptr)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr bool ids_unique() const
+    {
+        for (std::size_t i = 0u; i < N; i++)
+        {
+            for (std::size_t j = i + 1u; j < N; j++)
+            {
+                if (key[i].id == key[j].id)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    constexpr bool hw_unique() const
+    {
+        for (std::size_t i = 0u; i < N; i++)
+        {
+            for (std::size_t j = i + 1u; j < N; j++)
+            {
+                if (same_hw(key[i], key[j]))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    constexpr bool in_range() const
+    {
+        for (std::size_t i = 0u; i < N; i++)
+        {
+            if (key[i].backend == KB_BACKEND_MATRIX &&
+                (key[i].a >= KB_MATRIX_MAX_ROW || key[i].b >= KB_MATRIX_MAX_COL))
+            {
+                return false;
+            }
+            if (key[i].backend == KB_BACKEND_GPIO &&
+                (KB_GPIO_PORT_OF(key[i].a) >= KB_GPIO_MAX_PORTS || KB_GPIO_BIT_OF(key[i].a) >= 32u))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /* key_id 在键位表中的下标（即注册顺序，与 keyboard_get_key_state() 的 idx 一致），不存在时为 -1 */
+    constexpr int index_of(uint16_t id) const
+    {
+        for (std::size_t i = 0u; i < N; i++)
+        {
+            if (key[i].id == id)
+            {
+                return (int)i;
+            }
+        }
+        return -1;
+    }
+};
+
+template <typename... K>
+constexpr keymap<sizeof...(K)> make_keymap(const K &...k)
+{
+    static_assert(sizeof...(K) > 0u, "keymap must contain at least one key");
+    return keymap<sizeof...(K)>{{k...}};
+}
+
+/*
+ * 一个键盘实例：Map 为具有静态存储期的 constexpr keymap，Handler 以 (uint16_t key_id, kb_event_t evt) 调用。
+ * 驱动保存了实例地址作为回调参数，因此实例不可复制或移动，应放在静态存储中
+ */
+template <const auto &Map, typename Handler>
+class keyboard
+{
+    using map_t = std::remove_cv_t<std::remove_reference_t<decltype(Map)>>;
+
+    static constexpr std::size_t key_count = map_t::size();
+
+    static_assert(Map.backends_ok(), "keymap uses a backend not enabled in keyboard_config.h");
+    static_assert(Map.names_ok(), "keymap key without a name");
+    static_assert(Map.ids_unique(), "keymap contains duplicate key_id");
+    static_assert(Map.hw_unique(), "keymap contains duplicate hardware position");
+    static_assert(Map.in_range(), "keymap hardware position out of range");
+    static_assert(key_count <= KB_MAX_KEYS, "keymap has more keys than KB_MAX_KEYS");
+    static_assert(key_count <= (KEYBOARD_POOL_SIZE / pool_stride),
+                  "KEYBOARD_POOL_SIZE too small for keymap, see kb::pool_size_for");
+    static_assert(!KB_EXACT_KEYMAP_SIZE || key_count == KB_MAX_KEYS,
+                  "KB_EXACT_KEYMAP_SIZE: KB_MAX_KEYS must equal the keymap size");
+    static_assert(!KB_EXACT_KEYMAP_SIZE || KEYBOARD_POOL_SIZE == pool_size_for<key_count>,
+                  "KB_EXACT_KEYMAP_SIZE: KEYBOARD_POOL_SIZE must equal kb::pool_size_for<keymap size>");
+    static_assert(std::is_invocable_v<Handler &, uint16_t, kb_event_t>,
+                  "handler must be callable as handler(uint16_t key_id, kb_event_t evt)");
+
+public:
+    explicit keyboard(Handler handler) : ctl_(), handler_(handler)
+    {
+    }
+
+    keyboard(const keyboard &) = delete;
+    keyboard &operator=(const keyboard &) = delete;
+
+    /* 初始化驱动并按键位表顺序注册全部按键 */
+    int init(const keyboard_ops_t &ops)
+    {
+        keyboard_cb_t cb{};
+        int ret;
+
+        cb.on_event = &keyboard::on_event;
+        cb.user = this;
+        ret = keyboard_init(&ctl_, &ops, &cb);
+
+        for (std::size_t i = 0u; i < key_count && ret == KB_OK; i++)
+        {
+            const key_def &k = Map.key[i];
+            keyboard_key_cfg_t cfg = {};
+
+            cfg.keyname = k.name;
+            cfg.key_id = k.id;
+            if (k.backend == KB_BACKEND_GPIO)
+            {
+                cfg.hw.gpio_pin = k.a;
+            }
+            else if (k.backend == KB_BACKEND_MATRIX)
+            {
+                cfg.hw.matrix.row = k.a;
+                cfg.hw.matrix.col = k.b;
+            }
+            else
+            {
+                cfg.hw.hw_code = k.code;
+            }
+#if KB_USING_HYBRID
+            cfg.backend = k.backend;
+#endif
+            ret = keyboard_register_key(&cfg, &ctl_);
+        }
+        return ret;
+    }
+
+    void poll(uint32_t dt_ms)
+    {
+        keyboard_poll(&ctl_, dt_ms);
+    }
+
+    /* 其余 C 接口（等待事件、订阅、状态查询等）直接使用控制块 */
+    keyboard_control_t *control()
+    {
+        return &ctl_;
+    }
+
+    /* 编译期把 key_id 换成下标，未知的 key_id 无法通过编译 */
+    template <uint16_t Id>
+    static constexpr uint16_t index()
+    {
+        constexpr int idx = Map.index_of(Id);
+        static_assert(idx >= 0, "key_id not in keymap");
+        return (uint16_t)idx;
+    }
+
+    static constexpr std::size_t size()
+    {
+        return key_count;
+    }
+
+private:
+    static void on_event(const char *keyname, uint16_t key_id, kb_event_t evt, void *user)
+    {
+        (void)keyname;
+        static_cast<keyboard *>(user)->handler_(key_id, evt);
+    }
+
+    keyboard_control_t ctl_;
+    Handler handler_;
+};
+
+/* lambda 的类型无法写出，用工厂函数推导 Handler；C++17 保证返回值不经过复制 */
+template <const auto &Map, typename Handler>
+keyboard<Map, Handler> make_keyboard(Handler handler)
+{
+    return keyboard<Map, Handler>(handler);
+}
+
+} /* namespace kb */
+
+#endif /* MYCOMPONENTS_KEYBOARD_INC_KEYBOARD_HPP_ */
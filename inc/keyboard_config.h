@@ -13,7 +13,9 @@
 #include <stdint.h>
 
 /* 内存池总大小（字节），用于按键节点分配 */
+#ifndef KEYBOARD_POOL_SIZE
 #define KEYBOARD_POOL_SIZE 512u
+#endif
 
 /* 最大按键数量（独立按键/矩阵按键都使用这个上限） */
 #ifndef KB_MAX_KEYS
@@ -41,6 +43,28 @@
 #define KB_DOUBLE_CLICK_MS 250u
 #endif
 
+/*
+ * 事件检测开关：关闭后对应的判定代码和 kb_key_runtime_t 中的计时字段一起去掉，按下/释放始终检测。
+ * - 关闭双击时没有等待窗口，释放即发出单击
+ * - 关闭单击但保留双击时，双击窗口超时不发事件
+ * - 关闭长按时，长按后的释放按普通释放处理（可以计为单击）
+ */
+#ifndef KB_USING_CLICK
+#define KB_USING_CLICK 1u
+#endif
+
+#ifndef KB_USING_DOUBLE_CLICK
+#define KB_USING_DOUBLE_CLICK 1u
+#endif
+
+#ifndef KB_USING_LONGPRESS
+#define KB_USING_LONGPRESS 1u
+#endif
+
+#ifndef KB_USING_REPEAT
+#define KB_USING_REPEAT 1u
+#endif
+
 /*
  * 电平极性配置：
  * - GPIO/矩阵列输入，按下时是高电平(1)还是低电平(0)
@@ -77,12 +101,60 @@
 #define KB_BACKEND_GPIO   1u
 #define KB_BACKEND_MATRIX 2u
 #define KB_BACKEND_CUSTOM 3u
+#define KB_BACKEND_CAPTURE 4u   /* 定时器输入捕获/EXTI 时间戳：中断上报带硬件时间的边沿 */
 
 /* 默认使用矩阵键盘，可在工程配置里覆写 */
 #ifndef KB_BACKEND_MODE
 #define KB_BACKEND_MODE KB_BACKEND_MATRIX
 #endif
 
+/*
+ * 混合后端：按键注册时在 keyboard_key_cfg_t.backend 中指定各自的后端（0 表示 KB_BACKEND_MODE），
+ * 同一实例可以同时扫描 GPIO、矩阵和自定义按键；各组用自己的批量路径采样，共用一条事件流水线。
+ * 后端所需的操作在注册时检查。不能与 KB_BACKEND_CAPTURE 同时使用
+ */
+#ifndef KB_USING_HYBRID
+#define KB_USING_HYBRID 0u
+#endif
+
+/*
+ * 固定后端：固件只使用 KB_BACKEND_MODE 一种后端且 ops 在 init 后不再改变时开启。
+ * 采样路径在编译期选定，去掉逐键的后端 switch 和 ops 空指针检查（所需的 ops 由 init 检查一次）
+ */
+#ifndef KB_USING_FIXED_BACKEND
+#define KB_USING_FIXED_BACKEND 0u
+#endif
+
+/* 固定后端下 GPIO 的读取方式：1 使用 read_port（端口缓存），0 使用 read_pin */
+#ifndef KB_FIXED_GPIO_PORT
+#define KB_FIXED_GPIO_PORT 0u
+#endif
+
+/*
+ * BSP 内联绑定（需要 KB_USING_FIXED_BACKEND）：驱动包含用户提供的 keyboard_bsp.h，
+ * 其中用 KB_OP_xxx 宏（通常展开为 static inline 函数）给出 KB_BACKEND_MODE 所需的硬件访问。
+ * 采样循环直接内联这些访问，不再经过 keyboard_ops_t 的函数指针，对应的 ops 可以为 NULL
+ */
+#ifndef KB_USING_BSP_INLINE
+#define KB_USING_BSP_INLINE 0u
+#endif
+
+/*
+ * GPIO 端口映射（仅在提供 read_port 时使用）：注册时把 pin 拆成 (端口, 位)，
+ * poll 时每个用到的端口只读一次。默认每端口 16 位，pin = 端口 * 16 + 位；芯片不同可覆写
+ */
+#ifndef KB_GPIO_PORT_OF
+#define KB_GPIO_PORT_OF(pin) ((uint8_t)((pin) >> 4))
+#endif
+
+#ifndef KB_GPIO_BIT_OF
+#define KB_GPIO_BIT_OF(pin)  ((uint8_t)((pin) & 0x0Fu))
+#endif
+
+#ifndef KB_GPIO_MAX_PORTS
+#define KB_GPIO_MAX_PORTS 16u
+#endif
+
 /* 矩阵模式参数（仅矩阵后端使用） */
 #ifndef KB_MATRIX_MAX_ROW
 #define KB_MATRIX_MAX_ROW 8u
@@ -92,10 +164,206 @@
 #define KB_MATRIX_MAX_COL 8u
 #endif
 
+/* 追踪记录器：记录原始电平变化和事件，可通过串口导出（见 keyboard_trace.h） */
+#ifndef KB_USING_TRACE
+#define KB_USING_TRACE 0u
+#endif
+
+/*
+ * 批量去抖引擎（主机侧大规模按键阵列使用，如 Linux 上的老化测试台）：
+ * 按 SSE2/AVX2/NEON 向量化去抖和边沿检测，无可用指令集时使用可移植标量实现。
+ * 事件输出与默认逐键引擎完全一致；MCU 上按键少，保持 0 即可。
+ */
+#ifndef KB_USING_SIMD
+#define KB_USING_SIMD 0u
+#endif
+
+/*
+ * 事件队列：poll 产生的事件同时写入实例内的队列，应用任务可用 keyboard_wait_event() 阻塞等待，
+ * 不必再用回调或自行轮询标志。等待/通知依赖 keyboard_ops_t 中可选的 evt_post/evt_wait。
+ */
+#ifndef KB_USING_EVENT_QUEUE
+#define KB_USING_EVENT_QUEUE 0u
+#endif
+
+/* 2 的幂：队列为单生产者（poll）单消费者的无锁环，入队不调用 lock/unlock，poll 可以在中断中运行 */
+#ifndef KB_EVENT_QUEUE_LEN
+#define KB_EVENT_QUEUE_LEN 16u
+#endif
+
+/*
+ * 连发合并：消费者来不及取时，同一按键尚未取走的 KB_EVT_REPEAT 与新的连发合并为一条并累加 count，
+ * 长按不放也不会把队列塞满同样的记录。默认关闭：延迟分发时合并的连发对旧式 on_event 按 count 逐次回调，
+ * 只有能看到 count 的消费者（keyboard_wait_event、订阅者、按键处理器）才真正受益。
+ * 合并要修改已入队的记录，开启后 poll 入队时需持 lock/unlock
+ */
+#ifndef KB_USING_REPEAT_COALESCE
+#define KB_USING_REPEAT_COALESCE 0u
+#endif
+
+/*
+ * 延迟分发：keyboard_poll() 只把事件放入事件队列，由任务上下文调用 keyboard_dispatch() 执行回调，
+ * 适合在定时器中断中调用 poll 的场合（回调阻塞不会再拖慢扫描）。需要同时开启 KB_USING_EVENT_QUEUE。
+ * 提供 get_tick_us 时统计每个回调的耗时，超过 KB_DISPATCH_BUDGET_US 的计为超时。
+ */
+#ifndef KB_USING_DEFERRED_DISPATCH
+#define KB_USING_DEFERRED_DISPATCH 0u
+#endif
+
+#ifndef KB_DISPATCH_BUDGET_US
+#define KB_DISPATCH_BUDGET_US 1000u
+#endif
+
+/*
+ * 订阅者表：多个模块（界面、按键音、日志等）各自订阅关心的事件类型和按键，
+ * 分发时只调用感兴趣的订阅者，不再需要手写的回调复用器
+ */
+#ifndef KB_USING_SUBSCRIBER
+#define KB_USING_SUBSCRIBER 0u
+#endif
+
+#ifndef KB_MAX_SUBSCRIBERS
+#define KB_MAX_SUBSCRIBERS 4u
+#endif
+
+/*
+ * 连发加速：按住时间越长连发越快（阶梯表或指数曲线，Q8 定点），见 keyboard_set_repeat_profile()。
+ * 未设置曲线时仍按固定的 KB_REPEAT_PERIOD_MS 连发
+ */
+#ifndef KB_USING_REPEAT_ACCEL
+#define KB_USING_REPEAT_ACCEL 0u
+#endif
+
+/*
+ * 事件时间戳：keyboard_event_t.time_us 为事件实际发生的时刻，同一次 poll 内的事件按时间先后分发。
+ * 时钟优先用 get_tick_us，其次 get_tick_ms，都没有时按 poll 的 dt_ms 累计（精度为扫描周期）。
+ * 按下/释放取原始电平离开稳定电平的时刻（去抖之前），长按/连发/单击取计时到期的时刻
+ */
+#ifndef KB_USING_TIMESTAMP
+#define KB_USING_TIMESTAMP 0u
+#endif
+
+/*
+ * 输入捕获后端的边沿 FIFO 长度（2 的幂）。中断里 keyboard_capture_edge() 写入，poll 取出；
+ * 两次 poll 之间的边沿数超过它时退化为按当前电平重新同步
+ */
+#ifndef KB_EDGE_FIFO_LEN
+#define KB_EDGE_FIFO_LEN 32u
+#endif
+
+/*
+ * GPIO 中断模式（仅 GPIO 后端）：引脚变化中断调用 keyboard_gpio_irq() 把引脚标记为脏，
+ * poll 只读取脏引脚和仍在去抖的按键，空闲时不再逐个 read_pin；可选的 wakeup 操作让扫描任务立即 poll
+ */
+#ifndef KB_USING_GPIO_IRQ
+#define KB_USING_GPIO_IRQ 0u
+#endif
+
+/* 脏位图的原子操作，默认用 GCC/Clang 内建函数；没有原子指令的内核可改为关中断实现 */
+#ifndef KB_ATOMIC_OR32
+#define KB_ATOMIC_OR32(p, v)   ((void)__atomic_fetch_or((p), (v), __ATOMIC_RELEASE))
+#endif
+
+#ifndef KB_ATOMIC_XCHG32
+#define KB_ATOMIC_XCHG32(p, v) __atomic_exchange_n((p), (v), __ATOMIC_ACQUIRE)
+#endif
+
+#ifndef KB_ATOMIC_LOAD32
+#define KB_ATOMIC_LOAD32(p)    __atomic_load_n((p), __ATOMIC_RELAXED)
+#endif
+
+/* 事件队列、边沿 FIFO 下标的发布/获取（16 位）：单核 MCU 上可改为 volatile 读写 */
+#ifndef KB_ATOMIC_LOAD_ACQ16
+#define KB_ATOMIC_LOAD_ACQ16(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#endif
+
+#ifndef KB_ATOMIC_STORE_REL16
+#define KB_ATOMIC_STORE_REL16(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
+/* 内存屏障（订阅表的版本号校验） */
+#ifndef KB_ATOMIC_FENCE_ACQ
+#define KB_ATOMIC_FENCE_ACQ()  __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#endif
+
+#ifndef KB_ATOMIC_FENCE_REL
+#define KB_ATOMIC_FENCE_REL()  __atomic_thread_fence(__ATOMIC_RELEASE)
+#endif
+
+/* 指针的发布/获取（按键处理函数） */
+#ifndef KB_ATOMIC_LOAD_ACQ_PTR
+#define KB_ATOMIC_LOAD_ACQ_PTR(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#endif
+
+#ifndef KB_ATOMIC_STORE_REL_PTR
+#define KB_ATOMIC_STORE_REL_PTR(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
+/* 按键独立处理函数：与按键运行时状态存放在一起，分发时按下标直接调用，省去 switch (key_id) */
+#ifndef KB_USING_KEY_HANDLER
+#define KB_USING_KEY_HANDLER 0u
+#endif
+
 #if (KB_BACKEND_MODE != KB_BACKEND_GPIO) && \
     (KB_BACKEND_MODE != KB_BACKEND_MATRIX) && \
-    (KB_BACKEND_MODE != KB_BACKEND_CUSTOM)
-#error "KB_BACKEND_MODE must be KB_BACKEND_GPIO / KB_BACKEND_MATRIX / KB_BACKEND_CUSTOM"
+    (KB_BACKEND_MODE != KB_BACKEND_CUSTOM) && \
+    (KB_BACKEND_MODE != KB_BACKEND_CAPTURE)
+#error "KB_BACKEND_MODE must be KB_BACKEND_GPIO / KB_BACKEND_MATRIX / KB_BACKEND_CUSTOM / KB_BACKEND_CAPTURE"
+#endif
+
+#if (KB_BACKEND_MODE == KB_BACKEND_CAPTURE) && !KB_USING_TIMESTAMP
+#error "KB_BACKEND_CAPTURE requires KB_USING_TIMESTAMP"
+#endif
+
+#if (KB_BACKEND_MODE == KB_BACKEND_CAPTURE) && KB_USING_SIMD
+#error "KB_BACKEND_CAPTURE does not use the batch engine, set KB_USING_SIMD to 0"
+#endif
+
+#if KB_GPIO_MAX_PORTS > 32u
+#error "KB_GPIO_MAX_PORTS must not exceed 32"
+#endif
+
+#if KB_USING_HYBRID && (KB_BACKEND_MODE == KB_BACKEND_CAPTURE)
+#error "KB_USING_HYBRID does not support KB_BACKEND_CAPTURE"
+#endif
+
+#if KB_USING_FIXED_BACKEND && (KB_USING_HYBRID || (KB_BACKEND_MODE == KB_BACKEND_CAPTURE))
+#error "KB_USING_FIXED_BACKEND requires a single GPIO, MATRIX or CUSTOM backend"
+#endif
+
+#if KB_USING_BSP_INLINE && !KB_USING_FIXED_BACKEND
+#error "KB_USING_BSP_INLINE requires KB_USING_FIXED_BACKEND"
+#endif
+
+#if KB_USING_REPEAT_ACCEL && !KB_USING_REPEAT
+#error "KB_USING_REPEAT_ACCEL requires KB_USING_REPEAT"
+#endif
+
+/* 内部使用：长按/连发需要按下计时；按下计时或双击窗口需要每次 poll 推进计时 */
+#define KB_NEED_PRESS_TIMER (KB_USING_LONGPRESS || KB_USING_REPEAT)
+#define KB_NEED_KEY_TICK    (KB_NEED_PRESS_TIMER || KB_USING_DOUBLE_CLICK)
+
+/* 实例中可能出现的采集后端（内部使用）：混合模式下除输入捕获外都可能出现 */
+#define KB_HAS_BACKEND(m) (((KB_BACKEND_MODE) == (m)) || (KB_USING_HYBRID && ((m) != KB_BACKEND_CAPTURE)))
+
+#if KB_USING_GPIO_IRQ && !KB_HAS_BACKEND(KB_BACKEND_GPIO)
+#error "KB_USING_GPIO_IRQ requires KB_BACKEND_GPIO or KB_USING_HYBRID"
+#endif
+
+#if KB_USING_EVENT_QUEUE && ((KB_EVENT_QUEUE_LEN & (KB_EVENT_QUEUE_LEN - 1u)) != 0u || KB_EVENT_QUEUE_LEN > 32768u)
+#error "KB_EVENT_QUEUE_LEN must be a power of 2 and at most 32768"
+#endif
+
+#if (KB_EDGE_FIFO_LEN & (KB_EDGE_FIFO_LEN - 1u)) != 0u || KB_EDGE_FIFO_LEN > 32768u
+#error "KB_EDGE_FIFO_LEN must be a power of 2 and at most 32768"
+#endif
+
+#if KB_USING_DEFERRED_DISPATCH && !KB_USING_EVENT_QUEUE
+#error "KB_USING_DEFERRED_DISPATCH requires KB_USING_EVENT_QUEUE"
+#endif
+
+#if KB_USING_SUBSCRIBER && (KB_MAX_SUBSCRIBERS > 255u)
+#error "KB_MAX_SUBSCRIBERS must not exceed 255"
 #endif
 
 #if (KB_GPIO_ACTIVE_LEVEL > 1u) || (KB_MATRIX_ACTIVE_LEVEL > 1u) || \
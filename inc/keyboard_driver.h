@@ -13,6 +13,9 @@
 #include <stdint.h>
 #include "keyboard_config.h"
 #include "mypool.h"
+#if KB_USING_SIMD
+#include "keyboard_simd.h"
+#endif
 
 /* 矩阵键盘位置 */
 typedef struct
@@ -22,7 +25,7 @@ typedef struct
 } keyboard_matrix_pos_t;
 
 
-/* 硬件定位：独立 GPIO / 矩阵 row-col / 自定义编码 */
+/* 硬件定位：独立 GPIO / 矩阵 row-col / 自定义编码（输入捕获后端为通道号） */
 typedef union
 {
     uint8_t gpio_pin;
@@ -37,6 +40,9 @@ typedef struct
     const char *keyname;      /* 逻辑名称，如 "K_A" */
     uint16_t key_id;          /* 逻辑按键ID，业务层推荐用这个 */
     keyboard_hw_ref_t hw;     /* 硬件定位信息 */
+#if KB_USING_HYBRID
+    uint8_t backend;          /* 必填：KB_BACKEND_GPIO / MATRIX / CUSTOM，其他值（包括 0）注册时返回 KB_ERR_PARAM */
+#endif
 } keyboard_key_cfg_t;
 
 
@@ -46,6 +52,9 @@ typedef struct
     /* GPIO 后端：读取 pin 电平，返回 0/1 */
     uint8_t (*read_pin)(uint8_t pin);
 
+    /* GPIO 后端（可选，优先于 read_pin）：一次读取整个端口的输入寄存器，按 KB_GPIO_PORT_OF/BIT_OF 取位 */
+    uint32_t (*read_port)(uint8_t port);
+
     /* 矩阵后端：驱动行并读取列 */
     void (*matrix_select_row)(uint8_t row);
     uint8_t (*matrix_read_col)(uint8_t col);
@@ -61,9 +70,29 @@ typedef struct
     /* 获取当前毫秒 tick（可选，不提供则可以依赖 poll 的 dt_ms） */
     uint32_t (*get_tick_ms)(void);
 
-    /* 可选：多线程环境保护 */
+    /* 获取当前微秒 tick（可选，允许回绕），用于统计回调耗时 */
+    uint32_t (*get_tick_us)(void);
+
+    /*
+     * 可选：多线程环境保护（订阅/取消订阅之间、事件队列的消费者之间）。
+     * 事件入队、订阅表和按键处理函数的读取都是无锁的，poll 不调用 lock/unlock；只有开启 KB_USING_REPEAT_COALESCE 时 poll 入队才持锁，
+     * 此时若 poll 在中断中运行（延迟分发），lock/unlock 必须用关中断实现，不能用互斥量
+     */
     void (*lock)(void);
     void (*unlock)(void);
+
+    /*
+     * 可选：事件队列的通知/等待（KB_USING_EVENT_QUEUE），可用信号量或事件标志实现。
+     * evt_sem 原样传给两个函数；evt_wait 等到通知返回 0，超时返回非 0，
+     * timeout_ms 为 KB_WAIT_FOREVER 时一直等待。
+     * evt_post 在 poll 中调用，poll 在中断中运行时必须是中断安全的（如 rt_sem_release）
+     */
+    void *evt_sem;
+    void (*evt_post)(void *sem);
+    int (*evt_wait)(void *sem, uint32_t timeout_ms);
+
+    /* 可选（KB_USING_GPIO_IRQ）：keyboard_gpio_irq() 标记脏引脚后调用（中断上下文），通知扫描任务立即 poll */
+    void (*wakeup)(void);
 } keyboard_ops_t;
 
 
@@ -83,38 +112,296 @@ typedef enum
 } kb_event_t;
 
 
+#define KB_EVT_NUM         7u
+#define KB_EVT_MASK(evt)   ((uint8_t)(1u << (evt)))
+#define KB_EVT_MASK_ALL    ((uint8_t)((1u << KB_EVT_NUM) - 1u))
+
+
+/* 事件记录（事件队列、订阅者使用） */
+typedef struct
+{
+    const char *keyname;
+    uint16_t key_id;
+    uint16_t key_idx;         /* 注册顺序 */
+    uint16_t repeat_count;    /* KB_EVT_REPEAT: 本次按下的第几次连发（从 1 开始），其他事件为 0 */
+    uint16_t count;           /* 本记录代表的事件数：通常为 1，队列中合并的连发大于 1 */
+    kb_event_t evt;
+#if KB_USING_TIMESTAMP
+    uint32_t time_us;         /* 事件发生时刻（微秒，允许回绕）；合并的连发为最近一次的时刻 */
+#endif
+} keyboard_event_t;
+
+#define KB_WAIT_FOREVER 0xFFFFFFFFu
+
+
 /* keyboard 事件回调函数 */
 typedef void (*keyboard_event_cb)(const char *keyname, uint16_t key_id, kb_event_t evt, void *user);
 
 
+#if KB_USING_DEFERRED_DISPATCH
+/* 回调耗时超过预算时调用（在 keyboard_dispatch 中，回调返回之后） */
+typedef void (*keyboard_overrun_cb)(const keyboard_event_t *evt, uint32_t cost_us, void *user);
+#endif
+
+
 typedef struct
 {
     keyboard_event_cb on_event;
     void *user;
+#if KB_USING_DEFERRED_DISPATCH
+    keyboard_overrun_cb on_overrun;   /* 可选 */
+#endif
 } keyboard_cb_t;
 
 
+#if KB_USING_REPEAT_ACCEL
+#define KB_REPEAT_ACCEL_STEP 1u   /* 阶梯：连发次数达到 steps[i].count 后周期变为 steps[i].period_ms */
+#define KB_REPEAT_ACCEL_EXP  2u   /* 指数：每次连发后 period = period * factor_q8 / 256 */
+
+typedef struct
+{
+    uint16_t count;
+    uint16_t period_ms;
+} keyboard_repeat_step_t;
+
+/* 连发加速曲线，周期不低于 min_period_ms */
+typedef struct
+{
+    uint8_t mode;
+    uint8_t step_num;
+    uint16_t factor_q8;       /* EXP: 1~256，小于 256 表示加速，如 218 约为 0.85；超出范围时设置返回 KB_ERR_PARAM */
+    uint16_t min_period_ms;
+    const keyboard_repeat_step_t *steps;   /* STEP: 按 count 升序 */
+} keyboard_repeat_profile_t;
+#endif
+
+#if KB_USING_KEY_HANDLER
+typedef void (*keyboard_key_handler)(const keyboard_event_t *evt, void *user);
+
+/* 按键处理函数及其参数，由调用者提供并保持有效（通常为 static const） */
+typedef struct
+{
+    keyboard_key_handler on_event;
+    void *user;
+} keyboard_key_handler_t;
+#endif
+
+#if KB_USING_SUBSCRIBER
+typedef void (*keyboard_sub_cb)(const keyboard_event_t *evt, void *user);
+
+/* 订阅者：只接收 evt_mask 中的事件类型，并按 key_id 范围 / 按键位图过滤 */
+typedef struct
+{
+    keyboard_sub_cb on_event;
+    void *user;
+    uint8_t evt_mask;         /* KB_EVT_MASK(...) 的组合 */
+    uint16_t key_min;         /* key_id 范围（含两端），不过滤时取 0 / 0xFFFF */
+    uint16_t key_max;
+    const uint8_t *key_mask;  /* 可选：按注册顺序的位图，bit i 对应第 i 个按键，NULL 表示不过滤 */
+} keyboard_subscriber_t;
+
+/* 订阅表的一个版本：订阅者及按事件类型预先筛好的下标 */
+typedef struct
+{
+    keyboard_subscriber_t sub[KB_MAX_SUBSCRIBERS];
+    uint8_t list[KB_EVT_NUM][KB_MAX_SUBSCRIBERS];
+    uint8_t num[KB_EVT_NUM];
+} kb_sub_table_t;
+#endif
+
+
 /* keyboard 按键注册队列 */
 typedef struct keyboard_que
 {
     const char *keyname;
     uint16_t key_id;
     keyboard_hw_ref_t hw;
+#if KB_USING_HYBRID
+    uint8_t backend;          /* 该键的采集后端 */
+#endif
     struct keyboard_que *next;
 } keyboard_que_t;
 
 
+/* 按键运行时状态（按注册顺序，每个实例独立） */
+typedef struct
+{
+    uint8_t raw_last;
+    uint8_t stable;
+#if KB_USING_LONGPRESS
+    uint8_t long_sent;
+#endif
+#if KB_USING_DOUBLE_CLICK
+    uint8_t click_count;
+#endif
+#if KB_USING_REPEAT
+    uint16_t repeat_count;
+#endif
+#if KB_USING_REPEAT_ACCEL
+    uint16_t repeat_period;   /* 当前连发周期 */
+#endif
+    uint32_t debounce_ms;
+#if KB_NEED_PRESS_TIMER
+    uint32_t press_ms;
+#endif
+#if KB_USING_REPEAT
+    uint32_t repeat_ms;
+#endif
+#if KB_USING_DOUBLE_CLICK
+    uint32_t click_wait_ms;
+#endif
+#if (KB_BACKEND_MODE == KB_BACKEND_CAPTURE)
+    uint32_t raw_us;          /* 原始电平最近一次变化的时刻，去抖按它计时 */
+    uint32_t stable_us;       /* 当前稳定电平开始的边沿时刻，长按/连发/单击按它计时 */
+#endif
+#if KB_USING_TIMESTAMP
+    uint8_t edge_set;         /* 本次电平变化的起点已记录 */
+    uint32_t edge_us;         /* 原始电平离开稳定电平的时刻 */
+#endif
+#if KB_USING_KEY_HANDLER
+    const keyboard_key_handler_t *handler;  /* NULL 表示该键没有独立处理函数；只用 KB_ATOMIC_*_PTR 访问 */
+#endif
+} kb_key_runtime_t;
+
+/* 单次 poll 中判定出的待发事件，每键每次 poll 最多 4 个 */
+#define KB_PENDING_EVT_LEN (KB_MAX_KEYS * 4u)
+
+typedef struct
+{
+    const keyboard_que_t *node;
+    uint16_t idx;
+    uint16_t repeat_count;
+    kb_event_t evt;
+#if KB_USING_TIMESTAMP
+    uint32_t time_us;
+#endif
+} kb_pending_evt_t;
+
+#if KB_USING_SIMD
+/* 批量引擎的去抖状态按 SoA 排布，供向量内核整块处理 */
+typedef struct
+{
+    uint8_t raw_last[KB_SIMD_KEYS];
+    uint8_t stable[KB_SIMD_KEYS];
+    uint16_t deb[KB_SIMD_KEYS];
+    uint8_t busy[KB_SIMD_KEYS];
+    const keyboard_que_t *node[KB_MAX_KEYS];
+} kb_batch_state_t;
+#endif
+
+#if KB_USING_TRACE
+struct keyboard_trace;
+#endif
+
+#if KB_USING_HYBRID
+#define KB_KEY_IDX_NONE 0xFFFFu
+#endif
+
+#if KB_USING_GPIO_IRQ
+#define KB_GPIO_DIRTY_WORDS 8u    /* 每个 pin 号（0~255）一位 */
+#endif
+
+#if (KB_BACKEND_MODE == KB_BACKEND_CAPTURE)
+/* 捕获到的边沿：level 为按下(1)/松开(0)，time_us 与 get_tick_us 同一时钟 */
+typedef struct
+{
+    uint32_t time_us;
+    uint16_t idx;
+    uint8_t level;
+} kb_edge_t;
+#endif
+
 /* keyboard 控制结构体 */
 typedef struct
 {
-    uint8_t backend_mode;      /* 取值: KB_BACKEND_GPIO / MATRIX / CUSTOM */
+    uint8_t backend_mode;      /* 取值: KB_BACKEND_GPIO / MATRIX / CUSTOM；混合模式下每个按键的后端由注册时的 cfg.backend 决定 */
     keyboard_ops_t keyboard_ops;
     keyboard_cb_t keyboard_cb;
     keyboard_que_t *head;
     uint16_t key_num;
     mpool_t *keyboard_pool;
+    uint32_t evt_dropped;      /* 单次 poll 事件数超过缓存上限而丢弃的事件数 */
+#if KB_USING_TRACE
+    struct keyboard_trace *trace;   /* 追踪记录器，NULL 表示未开启 */
+    uint8_t polled;            /* 已调用过 keyboard_poll，trace 据此判断记录是否从初始化开始 */
+#endif
+#if KB_USING_EVENT_QUEUE
+    /* 单生产者（poll）单消费者的无锁环：evt_tail 只由 poll 写，evt_head 只由消费者写，均为自由递增的下标 */
+    keyboard_event_t evt_queue[KB_EVENT_QUEUE_LEN];
+    uint16_t evt_head;         /* 下一个出队位置 */
+    uint16_t evt_tail;         /* 下一个入队位置 */
+    uint32_t evt_queue_dropped;    /* 队列满而未入队的事件数 */
+#if !KB_USING_DEFERRED_DISPATCH
+    uint16_t evt_waiter;       /* 调用过 keyboard_wait_event() 后置 1，此前 poll 不入队；只用 KB_ATOMIC_*16 访问 */
+#endif
+#endif
+#if KB_USING_SUBSCRIBER
+    /* 双缓冲：sub_tab[sub_gen & 1] 为当前版本，订阅/取消订阅改写另一份后递增 sub_gen，分发时无锁读取 */
+    kb_sub_table_t sub_tab[2];
+    uint16_t sub_gen;          /* 只用 KB_ATOMIC_*16 访问 */
+#endif
+#if KB_USING_DEFERRED_DISPATCH
+    uint32_t cb_budget_us;     /* 单个回调的耗时预算，初始为 KB_DISPATCH_BUDGET_US */
+    uint32_t cb_max_us;        /* 观测到的最大回调耗时 */
+    uint32_t cb_overrun;       /* 超过预算的回调次数 */
+    keyboard_event_t cb_overrun_evt;   /* 最近一次超预算的事件 */
+#endif
+#if KB_USING_TIMESTAMP
+    uint32_t now_us;           /* 最近一次 poll 的时刻 */
+#endif
+#if KB_USING_HYBRID
+    uint8_t backend_used;      /* 已注册按键用到的后端，bit n 对应后端 n */
+    /* 按行串起的矩阵按键下标，注册时建立：poll 每行选通一次，只读该行的按键 */
+    uint16_t matrix_row_key[KB_MATRIX_MAX_ROW];   /* 该行第一个按键，KB_KEY_IDX_NONE 表示该行未使用 */
+    uint16_t matrix_next_key[KB_MAX_KEYS];        /* 同一行的下一个按键 */
+    uint8_t matrix_col[KB_MAX_KEYS];
+#endif
+#if KB_HAS_BACKEND(KB_BACKEND_GPIO)
+    uint8_t gpio_port[KB_MAX_KEYS];   /* 注册时由 KB_GPIO_PORT_OF/BIT_OF 算出 */
+    uint8_t gpio_bit[KB_MAX_KEYS];
+#endif
+#if KB_USING_GPIO_IRQ
+    uint32_t gpio_dirty[KB_GPIO_DIRTY_WORDS];  /* 中断置位、poll 原子取走，只用 KB_ATOMIC_* 访问 */
+#endif
+#if (KB_BACKEND_MODE == KB_BACKEND_CAPTURE)
+    /*
+     * 单生产者（捕获中断）单消费者（poll）的无锁环：edge_head 只由中断写，edge_tail 只由 poll 写，
+     * 两者只用 KB_ATOMIC_*16 发布/获取，槽位内容由它们排序
+     */
+    kb_edge_t edge_fifo[KB_EDGE_FIFO_LEN];
+    uint16_t edge_head;
+    uint16_t edge_tail;
+    volatile uint8_t edge_level[KB_MAX_KEYS];   /* 每个按键最近一次上报的电平，FIFO 溢出时用于重新同步 */
+    uint32_t edge_overrun;                      /* 中断置位、poll 原子取走，只用 KB_ATOMIC_* 访问 */
+    volatile uint32_t edge_dropped;             /* FIFO 满而丢弃的边沿数 */
+#endif
+
+    /* 以下为实例私有存储，由 keyboard_init() 初始化，多个实例互不影响 */
+    mpool_t key_pool;
+    void *key_pool_buf[(KEYBOARD_POOL_SIZE + sizeof(void *) - 1u) / sizeof(void *)];
+    kb_key_runtime_t key_rt[KB_MAX_KEYS];
+    kb_pending_evt_t pending_evt[KB_PENDING_EVT_LEN];  /* 仅 keyboard_poll 内部使用；放在控制块中，大量按键时不占用栈 */
+#if KB_USING_REPEAT_ACCEL
+    const keyboard_repeat_profile_t *repeat_profile;   /* NULL 表示固定周期 */
+#endif
+#if KB_USING_SIMD
+    kb_batch_state_t batch;
+#endif
 } keyboard_control_t;
 
+/* 单个按键的内部状态快照（调试/波形导出用），已关闭的检测对应的字段为 0 */
+typedef struct
+{
+    uint8_t raw;              /* 最近一次采样电平 */
+    uint8_t stable;           /* 去抖后的电平 */
+    uint8_t long_sent;
+    uint8_t click_count;
+    uint32_t debounce_ms;
+    uint32_t press_ms;
+    uint32_t repeat_ms;
+    uint32_t click_wait_ms;
+} keyboard_key_state_t;
+
 /* 统一返回码 */
 #define KB_OK              (0)
 #define KB_ERR_PARAM       (-1) /* 参数非法/空指针 */
@@ -124,6 +411,7 @@ typedef struct
 #define KB_ERR_DUPLICATE   (-5) /* 重复注册（key_id或硬件位重复） */
 #define KB_ERR_FULL        (-6) /* 注册数量达到上限 */
 #define KB_ERR_NOMEM       (-7) /* 内存池分配失败 */
+#define KB_ERR_TIMEOUT     (-8) /* 等待超时/队列为空 */
 
 int keyboard_init(keyboard_control_t *ctl, const keyboard_ops_t *ops, const keyboard_cb_t *cb);
 
@@ -141,4 +429,68 @@ int keyboard_register_matrix(uint8_t row, uint8_t col, const char *key_name, uin
 void keyboard_poll(keyboard_control_t *ctl, uint32_t dt_ms);
 
 
+#if KB_USING_GPIO_IRQ
+/* GPIO 中断模式：在引脚变化中断（双边沿）中调用，标记 pin 需要在下一次 poll 读取，并调用可选的 wakeup */
+void keyboard_gpio_irq(keyboard_control_t *ctl, uint8_t pin);
+
+/*
+ * 没有待读引脚、没有按键按下/去抖/等待双击时返回 1：扫描任务可以停止周期 poll，等待 wakeup。
+ * 混合模式下注册了非 GPIO 按键时始终返回 0（这些按键没有中断唤醒）
+ */
+uint8_t keyboard_is_idle(const keyboard_control_t *ctl);
+#endif
+
+
+#if (KB_BACKEND_MODE == KB_BACKEND_CAPTURE)
+/*
+ * 输入捕获后端：在捕获/EXTI 中断中上报第 idx 个注册按键的边沿（level 为 1 表示按下），
+ * time_us 取硬件捕获时刻，须与 get_tick_us 同一时钟。只写 FIFO，同一实例只能在一个中断优先级中调用。
+ * 返回 KB_OK；FIFO 满返回 KB_ERR_FULL（下一次 poll 按最新电平重新同步）
+ */
+int keyboard_capture_edge(keyboard_control_t *ctl, uint16_t idx, uint8_t level, uint32_t time_us);
+#endif
+
+
+#if KB_USING_EVENT_QUEUE
+/*
+ * 从事件队列取一个事件，队列为空时最多等待 timeout_ms（0 表示不等待，KB_WAIT_FOREVER 表示一直等）。
+ * 第一次调用之前产生的事件不入队（未开启延迟分发时）；未提供 get_tick_ms 时，有限超时在第一次空唤醒后即返回超时。
+ * 返回 KB_OK / KB_ERR_TIMEOUT；需要等待但未提供 evt_wait 时返回 KB_ERR_BACKEND
+ */
+int keyboard_wait_event(keyboard_control_t *ctl, keyboard_event_t *evt, uint32_t timeout_ms);
+#endif
+
+
+#if KB_USING_DEFERRED_DISPATCH
+/* 在任务上下文中执行队列中全部事件的回调，返回处理的事件数 */
+uint16_t keyboard_dispatch(keyboard_control_t *ctl);
+#endif
+
+
+#if KB_USING_REPEAT_ACCEL
+/* 设置连发加速曲线（profile 需保持有效，NULL 表示固定周期），下一次连发起生效 */
+int keyboard_set_repeat_profile(keyboard_control_t *ctl, const keyboard_repeat_profile_t *profile);
+#endif
+
+
+#if KB_USING_KEY_HANDLER
+/*
+ * 为已注册的按键设置独立处理函数（handler 需保持有效，NULL 表示取消），在 on_event 和订阅者之前调用。
+ * 函数和 user 以一个指针原子发布，分发时不持锁
+ */
+int keyboard_set_key_handler(keyboard_control_t *ctl, uint16_t key_id, const keyboard_key_handler_t *handler);
+#endif
+
+
+#if KB_USING_SUBSCRIBER
+/* 添加订阅者（内容被复制，key_mask 指向的位图需保持有效），返回句柄 >= 0 或错误码 */
+int keyboard_subscribe(keyboard_control_t *ctl, const keyboard_subscriber_t *sub);
+int keyboard_unsubscribe(keyboard_control_t *ctl, int handle);
+#endif
+
+
+/* 读取第 idx 个注册按键的内部状态（按注册顺序） */
+int keyboard_get_key_state(const keyboard_control_t *ctl, uint16_t idx, keyboard_key_state_t *state);
+
+
 #endif /* MYCOMPONENTS_KEYBOARD_INC_KEYBOARD_DRIVER_H_ */
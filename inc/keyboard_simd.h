@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+#ifndef MYCOMPONENTS_KEYBOARD_INC_KEYBOARD_SIMD_H_
+#define MYCOMPONENTS_KEYBOARD_INC_KEYBOARD_SIMD_H_
+
+#include <stdint.h>
+#include "keyboard_config.h"
+
+/*
+ * 批量去抖/边沿检测内核（内部接口，仅 KB_USING_SIMD 使用）
+ *
+ * 状态按 SoA 排布，每 32 个按键一组，数组长度需按 KB_SIMD_KEYS 对齐。
+ * 指令集在编译期选择：AVX2 > SSE2 > NEON > 可移植标量实现。
+ */
+#if KB_USING_SIMD
+
+#if defined(__AVX2__)
+#define KB_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define KB_SIMD_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define KB_SIMD_NEON 1
+#endif
+
+#if (KB_DEBOUNCE_MS > 32767u)
+#error "KB_USING_SIMD keeps debounce timers in 16 bits, KB_DEBOUNCE_MS must be <= 32767"
+#endif
+
+#define KB_SIMD_BLOCK  32u
+#define KB_SIMD_KEYS   (((KB_MAX_KEYS) + KB_SIMD_BLOCK - 1u) / KB_SIMD_BLOCK * KB_SIMD_BLOCK)
+#define KB_SIMD_WORDS  (KB_SIMD_KEYS / KB_SIMD_BLOCK)
+
+/*
+ * 对 [0, n) 个按键做一次去抖，n 向上取整到 32 处理：
+ *   raw      本次采样，非 0 即按下
+ *   raw_last 上次采样（0/1），原地更新
+ *   stable   去抖后电平（0/1），原地更新
+ *   deb      去抖计时，饱和在 KB_DEBOUNCE_MS
+ *   busy     非 0 表示该键仍有计时器在运行（按下中/等待双击）
+ *   attn     输出位图：采样变化、稳定电平变化或 busy 的按键置位，调用者只需处理这些按键
+ */
+void kb_simd_debounce(const uint8_t *raw, uint8_t *raw_last, uint8_t *stable, uint16_t *deb,
+                      const uint8_t *busy, uint32_t *attn, uint16_t n, uint32_t dt_ms);
+
+#endif /* KB_USING_SIMD */
+
+#endif /* MYCOMPONENTS_KEYBOARD_INC_KEYBOARD_SIMD_H_ */
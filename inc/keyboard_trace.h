@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+#ifndef MYCOMPONENTS_KEYBOARD_INC_KEYBOARD_TRACE_H_
+#define MYCOMPONENTS_KEYBOARD_INC_KEYBOARD_TRACE_H_
+
+#include <stdint.h>
+#include "keyboard_driver.h"
+
+/*
+ * 追踪记录器：环形缓冲里保存原始电平变化和输出事件，用于现场问题（如“幻影双击”）分析。
+ *
+ * 记录格式（每条记录 = 1 字节 tag + 可选 varint）：
+ * - tag 高 4 位为记录类型，低 4 位为参数
+ * - KB_TRACE_REC_POLL: 低 4 位 n=0 时后跟 varint dt_ms，表示一次 poll；
+ *                      n=1..15 表示连续 n 次 poll，dt 与上一次相同
+ * - KB_TRACE_REC_RAW : 低 4 位为新电平(0/1)，后跟 varint 按键索引（注册顺序）
+ * - KB_TRACE_REC_EVT : 低 4 位为 kb_event_t，后跟 varint 按键索引
+ *
+ * varint: 小端 7bit 分组，最高位为 1 表示后面还有字节。
+ * 缓冲满时丢弃最旧的整条记录，被丢弃部分的时间累计在 base_time_ms 中。
+ */
+#define KB_TRACE_REC_POLL  0x0u
+#define KB_TRACE_REC_RAW   0x1u
+#define KB_TRACE_REC_EVT   0x2u
+
+#define KB_TRACE_POLL_RUN_MAX  15u
+
+/* 单条记录最大长度：tag + 5 字节 varint */
+#define KB_TRACE_REC_MAX_LEN   6u
+
+/*
+ * dump 格式（小端）：
+ *   magic[4] = "KBT1"
+ *   flags    u8   bit0: 发生过覆盖（最旧记录已丢弃）
+ *                 bit1: 从 keyboard_init 之后、第一次 poll 之前开始记录，且之后未清空
+ *   key_num  u16
+ *   base_dt  u32  第一条记录之前生效的 dt（供 n>0 的 POLL 记录使用）
+ *   base_time_ms u32 被丢弃记录所覆盖的时间
+ *   data_len u32
+ *   features u8   KB_TRACE_FEATURES，录制端开启的事件检测
+ *   debounce_ms / longpress_ms / repeat_start_ms / repeat_period_ms / double_click_ms  u32 各一个，录制端的时间参数
+ *   key_id[key_num] u16
+ *   data[data_len]
+ *
+ * 回放要求初始状态已知（bit0 为 0 且 bit1 为 1），并且检测开关和时间参数与录制端一致
+ */
+#define KB_TRACE_MAGIC         "KBT1"
+#define KB_TRACE_HDR_LEN       40u
+#define KB_TRACE_FLAG_WRAPPED  0x01u
+#define KB_TRACE_FLAG_FROM_INIT 0x02u
+
+#define KB_TRACE_FEATURES      (uint8_t)((KB_USING_CLICK ? 0x01u : 0u) | (KB_USING_DOUBLE_CLICK ? 0x02u : 0u) | \
+                                         (KB_USING_LONGPRESS ? 0x04u : 0u) | (KB_USING_REPEAT ? 0x08u : 0u))
+
+typedef struct keyboard_trace
+{
+    uint8_t *buf;
+    uint32_t size;
+    uint32_t head;          /* 下一个写入位置 */
+    uint32_t tail;          /* 最旧记录起点 */
+    uint32_t used;          /* 已用字节数 */
+    uint32_t last_dt;       /* 最近一次 POLL 记录的 dt */
+    uint32_t run_pos;       /* 可合并的 POLL 记录位置 */
+    uint8_t run_valid;      /* run_pos 是否仍是最后一条记录 */
+    uint8_t flags;
+    uint32_t base_dt;
+    uint32_t base_time_ms;
+} keyboard_trace_t;
+
+/* 输出回调：dump 时逐段写出，如串口发送 */
+typedef void (*keyboard_trace_write_fn)(const uint8_t *data, uint16_t len, void *user);
+
+/* 开始/停止记录，buf 由调用者提供（建议静态数组）；要能回放，需在第一次 keyboard_poll 之前开始 */
+int keyboard_trace_start(keyboard_control_t *ctl, keyboard_trace_t *tr, uint8_t *buf, uint32_t size);
+void keyboard_trace_stop(keyboard_control_t *ctl);
+
+/* 清空已记录的数据 */
+void keyboard_trace_clear(keyboard_trace_t *tr);
+
+/* 导出：需要与 keyboard_poll 在同一上下文调用，或由调用者自行加锁 */
+int keyboard_trace_dump(const keyboard_control_t *ctl, keyboard_trace_write_fn write, void *user);
+
+/* 以下由 keyboard_poll 内部调用 */
+void keyboard_trace_on_poll(keyboard_trace_t *tr, uint32_t dt_ms);
+void keyboard_trace_on_raw(keyboard_trace_t *tr, uint16_t idx, uint8_t level);
+void keyboard_trace_on_event(keyboard_trace_t *tr, uint16_t idx, kb_event_t evt);
+
+#endif /* MYCOMPONENTS_KEYBOARD_INC_KEYBOARD_TRACE_H_ */
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE    /* accept4 */
+#endif
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include "keyboard_evsrv.h"
+
+#define KB_EVSRV_MASK (KB_EVSRV_CLIENT_BUF - 1u)
+
+static void kb_evsrv_close(kb_evsrv_client_t *c)
+{
+    close(c->fd);
+    c->fd = -1;
+}
+
+static void kb_evsrv_accept(kb_evsrv_t *srv)
+{
+    for (;;)
+    {
+        int fd = accept4(srv->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        uint16_t i;
+
+        if (fd < 0)
+        {
+            return;
+        }
+        for (i = 0u; i < KB_EVSRV_MAX_CLIENTS; i++)
+        {
+            if (srv->client[i].fd < 0)
+            {
+                break;
+            }
+        }
+        if (i >= KB_EVSRV_MAX_CLIENTS)
+        {
+            close(fd);
+            srv->rejected++;
+            continue;
+        }
+        srv->client[i].fd = fd;
+        srv->client[i].head = 0u;
+        srv->client[i].tail = 0u;
+        srv->client[i].sent = 0u;
+        srv->client[i].dropped = 0u;
+    }
+}
+
+/* 客户端不应发送数据，可读只用于发现对端关闭 */
+static void kb_evsrv_check_peer(kb_evsrv_client_t *c)
+{
+    uint8_t scratch[64];
+    ssize_t n;
+
+    do
+    {
+        n = recv(c->fd, scratch, sizeof(scratch), MSG_DONTWAIT);
+    } while (n > 0);
+
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+    {
+        kb_evsrv_close(c);
+    }
+}
+
+static void kb_evsrv_send(kb_evsrv_client_t *c)
+{
+    struct iovec iov[2];
+    struct msghdr msg;
+    uint32_t len = c->head - c->tail;
+    uint32_t off = c->tail & KB_EVSRV_MASK;
+    uint32_t first = KB_EVSRV_CLIENT_BUF - off;
+    ssize_t n;
+
+    if (len == 0u)
+    {
+        return;
+    }
+
+    /* 环形队列最多两段，一次 sendmsg 发出 */
+    memset(&msg, 0, sizeof(msg));
+    iov[0].iov_base = &c->buf[off];
+    if (len <= first)
+    {
+        iov[0].iov_len = len;
+        msg.msg_iovlen = 1u;
+    }
+    else
+    {
+        iov[0].iov_len = first;
+        iov[1].iov_base = c->buf;
+        iov[1].iov_len = len - first;
+        msg.msg_iovlen = 2u;
+    }
+    msg.msg_iov = iov;
+
+    n = sendmsg(c->fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n >= 0)
+    {
+        uint32_t done = (uint32_t)n;
+
+        /* 部分写出时只统计完整记录，剩余字节下次继续发 */
+        c->sent += ((c->tail % sizeof(kb_evsrv_rec_t)) + done) / sizeof(kb_evsrv_rec_t);
+        c->tail += done;
+    }
+    else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+    {
+        kb_evsrv_close(c);
+    }
+}
+
+int kb_evsrv_init(kb_evsrv_t *srv, const char *path)
+{
+    struct sockaddr_un addr;
+    uint16_t i;
+
+    if (srv == NULL || path == NULL || strlen(path) >= sizeof(addr.sun_path))
+    {
+        return KB_ERR_PARAM;
+    }
+
+    memset(srv, 0, sizeof(*srv));
+    for (i = 0u; i < KB_EVSRV_MAX_CLIENTS; i++)
+    {
+        srv->client[i].fd = -1;
+    }
+
+    srv->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (srv->listen_fd < 0)
+    {
+        return KB_ERR_BACKEND;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path, strlen(path) + 1u);
+    unlink(path);
+    if (bind(srv->listen_fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(srv->listen_fd, (int)KB_EVSRV_MAX_CLIENTS) != 0)
+    {
+        close(srv->listen_fd);
+        srv->listen_fd = -1;
+        return KB_ERR_BACKEND;
+    }
+
+    return KB_OK;
+}
+
+void kb_evsrv_on_event(const char *keyname, uint16_t key_id, kb_event_t evt, void *user)
+{
+    kb_evsrv_t *srv = (kb_evsrv_t *)user;
+    kb_evsrv_rec_t rec;
+    uint16_t i;
+
+    (void)keyname;
+
+    rec.seq = srv->seq++;
+    rec.key_id = key_id;
+    rec.evt = (uint8_t)evt;
+    rec.reserved = 0u;
+
+    for (i = 0u; i < KB_EVSRV_MAX_CLIENTS; i++)
+    {
+        kb_evsrv_client_t *c = &srv->client[i];
+        uint32_t off;
+
+        if (c->fd < 0)
+        {
+            continue;
+        }
+        if (KB_EVSRV_CLIENT_BUF - (c->head - c->tail) < sizeof(rec))
+        {
+            c->dropped++;
+            srv->dropped++;
+            continue;
+        }
+
+        /* 队列长度是记录长度的整数倍，记录不会跨越队尾 */
+        off = c->head & KB_EVSRV_MASK;
+        memcpy(&c->buf[off], &rec, sizeof(rec));
+        c->head += (uint32_t)sizeof(rec);
+    }
+}
+
+void kb_evsrv_flush(kb_evsrv_t *srv)
+{
+    struct pollfd pfd[KB_EVSRV_MAX_CLIENTS + 1u];
+    uint16_t map[KB_EVSRV_MAX_CLIENTS];
+    nfds_t n = 1u;
+    nfds_t k;
+    uint16_t i;
+
+    if (srv == NULL || srv->listen_fd < 0)
+    {
+        return;
+    }
+
+    /* 一次 poll 同时检查新连接和断开的客户端 */
+    pfd[0].fd = srv->listen_fd;
+    pfd[0].events = POLLIN;
+    pfd[0].revents = 0;
+    for (i = 0u; i < KB_EVSRV_MAX_CLIENTS; i++)
+    {
+        if (srv->client[i].fd >= 0)
+        {
+            pfd[n].fd = srv->client[i].fd;
+            pfd[n].events = POLLIN;
+            pfd[n].revents = 0;
+            map[n - 1u] = i;
+            n++;
+        }
+    }
+
+    if (poll(pfd, n, 0) > 0)
+    {
+        for (k = 1u; k < n; k++)
+        {
+            if (pfd[k].revents != 0)
+            {
+                kb_evsrv_check_peer(&srv->client[map[k - 1u]]);
+            }
+        }
+        if ((pfd[0].revents & POLLIN) != 0)
+        {
+            kb_evsrv_accept(srv);
+        }
+    }
+
+    for (i = 0u; i < KB_EVSRV_MAX_CLIENTS; i++)
+    {
+        if (srv->client[i].fd >= 0)
+        {
+            kb_evsrv_send(&srv->client[i]);
+        }
+    }
+}
+
+void kb_evsrv_deinit(kb_evsrv_t *srv)
+{
+    uint16_t i;
+
+    if (srv == NULL)
+    {
+        return;
+    }
+
+    for (i = 0u; i < KB_EVSRV_MAX_CLIENTS; i++)
+    {
+        if (srv->client[i].fd >= 0)
+        {
+            kb_evsrv_close(&srv->client[i]);
+        }
+    }
+    if (srv->listen_fd >= 0)
+    {
+        close(srv->listen_fd);
+        srv->listen_fd = -1;
+    }
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+#ifndef MYCOMPONENTS_KEYBOARD_PORT_LINUX_KEYBOARD_EVSRV_H_
+#define MYCOMPONENTS_KEYBOARD_PORT_LINUX_KEYBOARD_EVSRV_H_
+
+#include <stdint.h>
+#include "keyboard_driver.h"
+
+/*
+ * Unix 域套接字事件分发（库模式）
+ *
+ * 把 kb_evsrv_on_event 设为 keyboard 回调，每次 keyboard_poll() 之后调用一次 kb_evsrv_flush()：
+ * 本次 poll 的事件先追加到各客户端自己的有界发送队列，flush 时每个客户端最多一次 writev。
+ * 客户端 socket 为非阻塞，慢客户端的队列满后丢弃新事件并计数，不会阻塞扫描。
+ * 所有接口都应在调用 keyboard_poll 的同一线程中调用。
+ */
+#ifndef KB_EVSRV_MAX_CLIENTS
+#define KB_EVSRV_MAX_CLIENTS 8u
+#endif
+
+/* 每个客户端的发送队列字节数，必须为 2 的幂且是记录长度的整数倍 */
+#ifndef KB_EVSRV_CLIENT_BUF
+#define KB_EVSRV_CLIENT_BUF 4096u
+#endif
+
+#if (KB_EVSRV_CLIENT_BUF & (KB_EVSRV_CLIENT_BUF - 1u)) != 0u || KB_EVSRV_CLIENT_BUF < 8u
+#error "KB_EVSRV_CLIENT_BUF must be a power of 2 and at least 8"
+#endif
+
+/*
+ * 线上记录（8 字节，主机字节序）：
+ * seq 为服务端全局递增序号，客户端据此发现自己被丢弃的事件
+ */
+typedef struct
+{
+    uint32_t seq;
+    uint16_t key_id;
+    uint8_t evt;              /* kb_event_t */
+    uint8_t reserved;
+} kb_evsrv_rec_t;
+
+typedef struct
+{
+    int fd;                   /* -1 表示空闲 */
+    uint32_t head;            /* 已写入字节（自由递增，取模定位） */
+    uint32_t tail;            /* 已发送字节 */
+    uint64_t sent;            /* 已发送记录数 */
+    uint64_t dropped;         /* 队列满丢弃的记录数 */
+    uint8_t buf[KB_EVSRV_CLIENT_BUF];
+} kb_evsrv_client_t;
+
+typedef struct
+{
+    int listen_fd;
+    uint32_t seq;
+    uint64_t dropped;         /* 所有客户端累计丢弃数 */
+    uint64_t rejected;        /* 客户端数已满而拒绝的连接数 */
+    kb_evsrv_client_t client[KB_EVSRV_MAX_CLIENTS];
+} kb_evsrv_t;
+
+/* 在 path 上监听（已存在的 socket 文件会被删除） */
+int kb_evsrv_init(kb_evsrv_t *srv, const char *path);
+
+/* keyboard 事件回调，user 传入 kb_evsrv_t * */
+void kb_evsrv_on_event(const char *keyname, uint16_t key_id, kb_event_t evt, void *user);
+
+/* 接受新连接、回收断开的客户端，并把各队列中的数据各用一次系统调用发出 */
+void kb_evsrv_flush(kb_evsrv_t *srv);
+
+void kb_evsrv_deinit(kb_evsrv_t *srv);
+
+#endif /* MYCOMPONENTS_KEYBOARD_PORT_LINUX_KEYBOARD_EVSRV_H_ */
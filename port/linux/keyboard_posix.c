@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+
+#include <time.h>
+#include "keyboard_posix.h"
+
+static pthread_mutex_t kb_posix_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void kb_posix_lock(void)
+{
+    pthread_mutex_lock(&kb_posix_mutex);
+}
+
+void kb_posix_unlock(void)
+{
+    pthread_mutex_unlock(&kb_posix_mutex);
+}
+
+int kb_posix_sem_init(kb_posix_sem_t *sem)
+{
+    pthread_condattr_t attr;
+
+    if (sem == NULL)
+    {
+        return KB_ERR_PARAM;
+    }
+
+    sem->count = 0u;
+    if (pthread_mutex_init(&sem->lock, NULL) != 0)
+    {
+        return KB_ERR_BACKEND;
+    }
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    if (pthread_cond_init(&sem->cv, &attr) != 0)
+    {
+        pthread_condattr_destroy(&attr);
+        pthread_mutex_destroy(&sem->lock);
+        return KB_ERR_BACKEND;
+    }
+    pthread_condattr_destroy(&attr);
+
+    return KB_OK;
+}
+
+void kb_posix_sem_deinit(kb_posix_sem_t *sem)
+{
+    pthread_cond_destroy(&sem->cv);
+    pthread_mutex_destroy(&sem->lock);
+}
+
+void kb_posix_sem_post(void *sem)
+{
+    kb_posix_sem_t *s = (kb_posix_sem_t *)sem;
+
+    pthread_mutex_lock(&s->lock);
+    s->count++;
+    pthread_cond_signal(&s->cv);
+    pthread_mutex_unlock(&s->lock);
+}
+
+int kb_posix_sem_wait(void *sem, uint32_t timeout_ms)
+{
+    kb_posix_sem_t *s = (kb_posix_sem_t *)sem;
+    struct timespec ts;
+    int ret = 0;
+
+    if (timeout_ms != KB_WAIT_FOREVER)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        ts.tv_sec += (time_t)(timeout_ms / 1000u);
+        ts.tv_nsec += (long)(timeout_ms % 1000u) * 1000000L;
+        if (ts.tv_nsec >= 1000000000L)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&s->lock);
+    while (s->count == 0u && ret == 0)
+    {
+        if (timeout_ms == KB_WAIT_FOREVER)
+        {
+            ret = pthread_cond_wait(&s->cv, &s->lock);
+        }
+        else
+        {
+            ret = pthread_cond_timedwait(&s->cv, &s->lock, &ts);
+        }
+    }
+    if (s->count != 0u)
+    {
+        s->count--;
+        ret = 0;
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    return (ret == 0) ? 0 : -1;
+}
+
+uint32_t kb_posix_tick_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u);
+}
+
+uint32_t kb_posix_tick_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u);
+}
+
+void kb_posix_bind_ops(keyboard_ops_t *ops, kb_posix_sem_t *sem)
+{
+    ops->lock = kb_posix_lock;
+    ops->unlock = kb_posix_unlock;
+    ops->get_tick_ms = kb_posix_tick_ms;
+    ops->get_tick_us = kb_posix_tick_us;
+    ops->evt_sem = sem;
+    ops->evt_post = kb_posix_sem_post;
+    ops->evt_wait = kb_posix_sem_wait;
+}
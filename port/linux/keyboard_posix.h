@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+#ifndef MYCOMPONENTS_KEYBOARD_PORT_LINUX_KEYBOARD_POSIX_H_
+#define MYCOMPONENTS_KEYBOARD_PORT_LINUX_KEYBOARD_POSIX_H_
+
+#include <stdint.h>
+#include <pthread.h>
+#include "keyboard_driver.h"
+
+/*
+ * keyboard_ops_t 中可选操作的 POSIX 实现：
+ * - lock/unlock：进程内全局互斥锁（ops 中的 lock 不带参数，所有实例共用）
+ * - evt_post/evt_wait：计数信号量，基于 CLOCK_MONOTONIC 条件变量，不受系统时间调整影响
+ */
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cv;
+    uint32_t count;
+} kb_posix_sem_t;
+
+void kb_posix_lock(void);
+void kb_posix_unlock(void);
+
+int kb_posix_sem_init(kb_posix_sem_t *sem);
+void kb_posix_sem_deinit(kb_posix_sem_t *sem);
+void kb_posix_sem_post(void *sem);
+int kb_posix_sem_wait(void *sem, uint32_t timeout_ms);
+
+/* CLOCK_MONOTONIC 毫秒 */
+uint32_t kb_posix_tick_ms(void);
+
+/* CLOCK_MONOTONIC 微秒（32 位回绕） */
+uint32_t kb_posix_tick_us(void);
+
+/* 把以上实现填入 ops 的 lock、unlock、get_tick_ms、get_tick_us 和 evt_sem/evt_post/evt_wait，其余字段不变 */
+void kb_posix_bind_ops(keyboard_ops_t *ops, kb_posix_sem_t *sem);
+
+#endif /* MYCOMPONENTS_KEYBOARD_PORT_LINUX_KEYBOARD_POSIX_H_ */
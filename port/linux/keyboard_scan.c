@@ -0,0 +1,369 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+
+#include <poll.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include "keyboard_scan.h"
+
+#define KB_SCAN_QUEUE_MASK (KB_SCAN_QUEUE_LEN - 1u)
+
+static uint64_t kb_scan_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * 有界 MPMC 队列（Vyukov）：slot.seq == pos 表示可写，== pos + 1 表示可读。
+ * 入队/出队各一次 CAS，不需要锁，也不会因为某个消费者被挂起而阻塞扫描线程。
+ */
+static int kb_scan_push(kb_scan_t *s, const kb_scan_evt_t *evt)
+{
+    uint32_t pos = atomic_load_explicit(&s->enq_pos, memory_order_relaxed);
+
+    for (;;)
+    {
+        kb_scan_slot_t *slot = &s->slot[pos & KB_SCAN_QUEUE_MASK];
+        uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&s->enq_pos, &pos, pos + 1u,
+                                                      memory_order_relaxed, memory_order_relaxed))
+            {
+                slot->evt = *evt;
+                atomic_store_explicit(&slot->seq, pos + 1u, memory_order_release);
+                return 1;
+            }
+        }
+        else if (diff < 0)
+        {
+            return 0;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&s->enq_pos, memory_order_relaxed);
+        }
+    }
+}
+
+int kb_scan_pop(kb_scan_t *s, kb_scan_evt_t *evt)
+{
+    uint32_t pos = atomic_load_explicit(&s->deq_pos, memory_order_relaxed);
+
+    for (;;)
+    {
+        kb_scan_slot_t *slot = &s->slot[pos & KB_SCAN_QUEUE_MASK];
+        uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int32_t diff = (int32_t)(seq - (pos + 1u));
+
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&s->deq_pos, &pos, pos + 1u,
+                                                      memory_order_relaxed, memory_order_relaxed))
+            {
+                *evt = slot->evt;
+                atomic_store_explicit(&slot->seq, pos + KB_SCAN_QUEUE_LEN, memory_order_release);
+                return 1;
+            }
+        }
+        else if (diff < 0)
+        {
+            return 0;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&s->deq_pos, memory_order_relaxed);
+        }
+    }
+}
+
+int kb_scan_wait(kb_scan_t *s, kb_scan_evt_t *evt, int timeout_ms)
+{
+    uint64_t deadline = 0u;
+    uint64_t token;
+    int ret = 0;
+
+    if (timeout_ms > 0)
+    {
+        deadline = kb_scan_now_ns() + (uint64_t)timeout_ms * 1000000u;
+    }
+
+    /*
+     * eventfd 为信号量模式，每个入队事件对应一个计数，一次 read 只唤醒一个消费者。
+     * 快路径直接出队时计数会多出来，只会造成一次多余的唤醒，不会丢失唤醒。
+     * 先登记为等待者再检查 quit：kb_scan_stop() 置 quit 后等待者归零，此后不会再有人访问 evt_fd。
+     */
+    atomic_fetch_add(&s->waiters, 1u);
+    for (;;)
+    {
+        struct pollfd pfd;
+        int wait_ms = timeout_ms;
+
+        if (kb_scan_pop(s, evt))
+        {
+            ret = 1;
+            break;
+        }
+        if (atomic_load(&s->quit) != 0)
+        {
+            break;
+        }
+        if (timeout_ms > 0)
+        {
+            uint64_t now = kb_scan_now_ns();
+
+            if (now >= deadline)
+            {
+                break;
+            }
+            wait_ms = (int)((deadline - now + 999999u) / 1000000u);
+        }
+
+        pfd.fd = s->evt_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, wait_ms) == 0)
+        {
+            ret = kb_scan_pop(s, evt);
+            break;
+        }
+        /* 停止时写入的唤醒令牌不读走，留给其他阻塞中的消费者 */
+        if (atomic_load(&s->quit) != 0)
+        {
+            continue;
+        }
+        (void)read(s->evt_fd, &token, sizeof(token));
+    }
+    atomic_fetch_sub(&s->waiters, 1u);
+
+    return ret;
+}
+
+static void kb_scan_on_event(const char *keyname, uint16_t key_id, kb_event_t evt, void *user)
+{
+    kb_scan_t *s = (kb_scan_t *)user;
+    kb_scan_evt_t e;
+    uint64_t one = 1u;
+
+    e.keyname = keyname;
+    e.key_id = key_id;
+    e.evt = (uint8_t)evt;
+    e.time_ns = s->poll_time_ns;
+
+    if (kb_scan_push(s, &e))
+    {
+        (void)write(s->evt_fd, &one, sizeof(one));
+    }
+    else
+    {
+        atomic_fetch_add_explicit(&s->st_dropped, 1u, memory_order_relaxed);
+    }
+}
+
+static void kb_scan_update_jitter(kb_scan_t *s, uint64_t late_ns)
+{
+    uint32_t late_us = (late_ns > 0xFFFFFFFFull * 1000u) ? 0xFFFFFFFFu : (uint32_t)(late_ns / 1000u);
+
+    /* 只有扫描线程写，读-改-写不需要 CAS */
+    if (late_us < atomic_load_explicit(&s->st_jitter_min_us, memory_order_relaxed))
+    {
+        atomic_store_explicit(&s->st_jitter_min_us, late_us, memory_order_relaxed);
+    }
+    if (late_us > atomic_load_explicit(&s->st_jitter_max_us, memory_order_relaxed))
+    {
+        atomic_store_explicit(&s->st_jitter_max_us, late_us, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&s->st_jitter_sum_us, late_us, memory_order_relaxed);
+}
+
+/* 绝对时间定时，周期点不随唤醒延迟漂移；first_ns 为第一个周期点 */
+static int kb_scan_arm_timer(kb_scan_t *s)
+{
+    uint64_t period_ns = (uint64_t)s->cfg.period_ms * 1000000u;
+    struct itimerspec its;
+
+    s->first_ns = kb_scan_now_ns() + period_ns;
+    its.it_value.tv_sec = (time_t)(s->first_ns / 1000000000u);
+    its.it_value.tv_nsec = (long)(s->first_ns % 1000000000u);
+    its.it_interval.tv_sec = (time_t)(period_ns / 1000000000u);
+    its.it_interval.tv_nsec = (long)(period_ns % 1000000000u);
+    return timerfd_settime(s->timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+static void *kb_scan_thread(void *arg)
+{
+    kb_scan_t *s = (kb_scan_t *)arg;
+    uint64_t period_ns = (uint64_t)s->cfg.period_ms * 1000000u;
+    uint64_t expect_ns = s->first_ns;
+
+    while (!atomic_load_explicit(&s->quit, memory_order_acquire))
+    {
+        uint64_t exp = 0u;
+        uint64_t now;
+
+        if (read(s->timer_fd, &exp, sizeof(exp)) != (ssize_t)sizeof(exp) || exp == 0u)
+        {
+            continue;
+        }
+        now = kb_scan_now_ns();
+
+        /* 本次唤醒对应的周期点为最后一个到期点 */
+        expect_ns += period_ns * (exp - 1u);
+        kb_scan_update_jitter(s, (now > expect_ns) ? (now - expect_ns) : 0u);
+        expect_ns += period_ns;
+
+        if (exp > 1u)
+        {
+            atomic_fetch_add_explicit(&s->st_missed, exp - 1u, memory_order_relaxed);
+        }
+
+        s->poll_time_ns = now;
+        keyboard_poll(s->ctl, (uint32_t)(s->cfg.period_ms * exp));
+        atomic_fetch_add_explicit(&s->st_polls, 1u, memory_order_relaxed);
+    }
+    return NULL;
+}
+
+int kb_scan_init(kb_scan_t *s, keyboard_control_t *ctl, const kb_scan_cfg_t *cfg)
+{
+    uint32_t i;
+
+    if (s == NULL || ctl == NULL || cfg == NULL || cfg->period_ms == 0u)
+    {
+        return KB_ERR_PARAM;
+    }
+
+    memset(s, 0, sizeof(*s));
+    s->ctl = ctl;
+    s->cfg = *cfg;
+    s->timer_fd = -1;
+    s->evt_fd = -1;
+    for (i = 0u; i < KB_SCAN_QUEUE_LEN; i++)
+    {
+        atomic_init(&s->slot[i].seq, i);
+    }
+    atomic_init(&s->st_jitter_min_us, 0xFFFFFFFFu);
+
+    ctl->keyboard_cb.on_event = kb_scan_on_event;
+    ctl->keyboard_cb.user = s;
+
+    return KB_OK;
+}
+
+int kb_scan_start(kb_scan_t *s)
+{
+    pthread_attr_t attr;
+    int ret = -1;
+
+    if (s == NULL || s->ctl == NULL)
+    {
+        return KB_ERR_PARAM;
+    }
+
+    s->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    s->evt_fd = eventfd(0u, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE);
+    if (s->timer_fd < 0 || s->evt_fd < 0)
+    {
+        kb_scan_stop(s);
+        return KB_ERR_BACKEND;
+    }
+
+    /* 在创建线程之前设好定时器，失败时直接返回，不会留下一个永远不 poll 的扫描线程 */
+    if (kb_scan_arm_timer(s) != 0)
+    {
+        kb_scan_stop(s);
+        return KB_ERR_BACKEND;
+    }
+    atomic_store(&s->quit, 0);
+
+    if (s->cfg.rt_priority > 0)
+    {
+        struct sched_param sp;
+
+        memset(&sp, 0, sizeof(sp));
+        sp.sched_priority = s->cfg.rt_priority;
+        pthread_attr_init(&attr);
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        pthread_attr_setschedparam(&attr, &sp);
+        ret = pthread_create(&s->tid, &attr, kb_scan_thread, s);
+        pthread_attr_destroy(&attr);
+        atomic_store(&s->st_rt_active, (uint8_t)(ret == 0));
+    }
+    if (ret != 0 && pthread_create(&s->tid, NULL, kb_scan_thread, s) != 0)
+    {
+        kb_scan_stop(s);
+        return KB_ERR_BACKEND;
+    }
+    s->running = 1u;
+
+    return KB_OK;
+}
+
+void kb_scan_stop(kb_scan_t *s)
+{
+    uint64_t one = 1u;
+
+    if (s == NULL)
+    {
+        return;
+    }
+
+    atomic_store(&s->quit, 1);
+    if (s->running != 0u)
+    {
+        /* 扫描线程最迟在下一个周期点醒来并退出 */
+        pthread_join(s->tid, NULL);
+        s->running = 0u;
+    }
+    /*
+     * 唤醒阻塞中的消费者，它们看到 quit 后返回 0。令牌可能被置 quit 前已醒来的消费者读走，
+     * 所以在等待者归零前持续补发
+     */
+    while (atomic_load(&s->waiters) != 0u)
+    {
+        (void)write(s->evt_fd, &one, sizeof(one));
+        sched_yield();
+    }
+    if (s->timer_fd >= 0)
+    {
+        close(s->timer_fd);
+        s->timer_fd = -1;
+    }
+    if (s->evt_fd >= 0)
+    {
+        close(s->evt_fd);
+        s->evt_fd = -1;
+    }
+}
+
+void kb_scan_get_stats(const kb_scan_t *s, kb_scan_stats_t *st)
+{
+    uint64_t polls = atomic_load_explicit(&s->st_polls, memory_order_relaxed);
+    uint32_t jmin = atomic_load_explicit(&s->st_jitter_min_us, memory_order_relaxed);
+
+    st->polls = polls;
+    st->missed = atomic_load_explicit(&s->st_missed, memory_order_relaxed);
+    st->evt_dropped = atomic_load_explicit(&s->st_dropped, memory_order_relaxed);
+    st->jitter_min_us = (polls == 0u) ? 0u : jmin;
+    st->jitter_max_us = atomic_load_explicit(&s->st_jitter_max_us, memory_order_relaxed);
+    st->jitter_avg_us = (polls == 0u) ? 0u :
+                        (uint32_t)(atomic_load_explicit(&s->st_jitter_sum_us, memory_order_relaxed) / polls);
+    st->rt_active = atomic_load_explicit(&s->st_rt_active, memory_order_relaxed);
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+#ifndef MYCOMPONENTS_KEYBOARD_PORT_LINUX_KEYBOARD_SCAN_H_
+#define MYCOMPONENTS_KEYBOARD_PORT_LINUX_KEYBOARD_SCAN_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "keyboard_driver.h"
+
+/*
+ * 专用扫描线程（Linux HMI 参考部署）
+ *
+ * 扫描线程由 timerfd 按固定周期唤醒（可选 SCHED_FIFO），调用 keyboard_poll()，
+ * 事件写入无锁有界队列（多生产者/多消费者，按槽位序号同步），消费者线程从队列取出。
+ * 同时统计唤醒抖动（实际唤醒时刻相对理论周期点的延迟）和错过的周期数。
+ *
+ * 错过周期时 timerfd 返回的到期次数大于 1，此时以 “次数 × 周期” 作为 dt 调用一次 keyboard_poll，
+ * 去抖/长按计时仍按真实流逝的时间推进。
+ */
+
+/* 事件队列长度，必须为 2 的幂 */
+#ifndef KB_SCAN_QUEUE_LEN
+#define KB_SCAN_QUEUE_LEN 256u
+#endif
+
+#if (KB_SCAN_QUEUE_LEN & (KB_SCAN_QUEUE_LEN - 1u)) != 0u
+#error "KB_SCAN_QUEUE_LEN must be a power of 2"
+#endif
+
+/* 队列中的事件记录 */
+typedef struct
+{
+    const char *keyname;
+    uint16_t key_id;
+    uint8_t evt;              /* kb_event_t */
+    uint64_t time_ns;         /* 产生该事件的 poll 时刻（CLOCK_MONOTONIC） */
+} kb_scan_evt_t;
+
+typedef struct
+{
+    _Atomic uint32_t seq;
+    kb_scan_evt_t evt;
+} kb_scan_slot_t;
+
+typedef struct
+{
+    uint32_t period_ms;       /* 扫描周期，同时作为 keyboard_poll 的 dt 单位 */
+    int rt_priority;          /* >0: 以该优先级 SCHED_FIFO 运行；0: 普通调度 */
+} kb_scan_cfg_t;
+
+/* 统计（各字段单独原子更新，读取时不保证彼此严格一致） */
+typedef struct
+{
+    uint64_t polls;           /* 扫描线程唤醒次数 */
+    uint64_t missed;          /* 错过的周期数（到期次数 - 1 的累计） */
+    uint64_t evt_dropped;     /* 队列满而丢弃的事件数 */
+    uint32_t jitter_min_us;   /* 唤醒延迟最小值 */
+    uint32_t jitter_max_us;   /* 唤醒延迟最大值 */
+    uint32_t jitter_avg_us;   /* 唤醒延迟平均值 */
+    uint8_t rt_active;        /* SCHED_FIFO 是否生效（权限不足时退回普通调度） */
+} kb_scan_stats_t;
+
+typedef struct
+{
+    keyboard_control_t *ctl;
+    kb_scan_cfg_t cfg;
+    pthread_t tid;
+    uint8_t running;
+    int timer_fd;
+    int evt_fd;               /* eventfd（信号量模式），每入队一个事件加 1，可加入消费者的 epoll */
+    _Atomic int quit;
+    _Atomic uint32_t waiters;  /* 正在 kb_scan_wait() 中的消费者数，归零后 kb_scan_stop() 才关闭 evt_fd */
+    uint64_t poll_time_ns;    /* 当前 poll 的时刻，仅扫描线程访问 */
+    uint64_t first_ns;        /* 第一个周期点，kb_scan_start() 设置定时器时写入 */
+
+    /* 无锁队列：生产者与消费者的位置分别放在独立缓存行 */
+    _Atomic uint32_t enq_pos __attribute__((aligned(64)));
+    _Atomic uint32_t deq_pos __attribute__((aligned(64)));
+    kb_scan_slot_t slot[KB_SCAN_QUEUE_LEN] __attribute__((aligned(64)));
+
+    _Atomic uint64_t st_polls;
+    _Atomic uint64_t st_missed;
+    _Atomic uint64_t st_dropped;
+    _Atomic uint64_t st_jitter_sum_us;
+    _Atomic uint32_t st_jitter_min_us;
+    _Atomic uint32_t st_jitter_max_us;
+    _Atomic uint8_t st_rt_active;
+} kb_scan_t;
+
+/*
+ * 绑定实例并接管其事件回调（ctl->keyboard_cb 被替换为入队函数）。
+ * ctl 需已 keyboard_init()，按键注册应在 kb_scan_start() 之前完成。
+ */
+int kb_scan_init(kb_scan_t *s, keyboard_control_t *ctl, const kb_scan_cfg_t *cfg);
+
+/* 创建扫描线程；SCHED_FIFO 因权限不足失败时以普通调度运行，见 stats.rt_active */
+int kb_scan_start(kb_scan_t *s);
+
+/*
+ * 停止扫描线程，唤醒阻塞在 kb_scan_wait() 中的消费者（返回 0），等它们全部返回后释放 fd。
+ * 自行把 evt_fd 加入 epoll 的消费者应在调用前移除它
+ */
+void kb_scan_stop(kb_scan_t *s);
+
+/* 非阻塞取一个事件：成功返回 1，队列空返回 0。可在任意多个线程中并发调用 */
+int kb_scan_pop(kb_scan_t *s, kb_scan_evt_t *evt);
+
+/* 阻塞等待一个事件，timeout_ms < 0 表示一直等待：成功返回 1，超时或已 kb_scan_stop() 返回 0 */
+int kb_scan_wait(kb_scan_t *s, kb_scan_evt_t *evt, int timeout_ms);
+
+void kb_scan_get_stats(const kb_scan_t *s, kb_scan_stats_t *st);
+
+#endif /* MYCOMPONENTS_KEYBOARD_PORT_LINUX_KEYBOARD_SCAN_H_ */
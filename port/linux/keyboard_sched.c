@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+
+#include <unistd.h>
+#include "keyboard_sched.h"
+
+#define KB_RANGE(b, e)    (((uint64_t)(e) << 32) | (uint32_t)(b))
+#define KB_RANGE_BEGIN(r) ((uint32_t)(r))
+#define KB_RANGE_END(r)   ((uint32_t)((r) >> 32))
+
+/* 从自己的队头取一个实例 */
+static int kb_sched_pop(kb_sched_worker_t *w, uint32_t *idx)
+{
+    uint64_t r = atomic_load_explicit(&w->range, memory_order_relaxed);
+
+    while (KB_RANGE_BEGIN(r) < KB_RANGE_END(r))
+    {
+        if (atomic_compare_exchange_weak_explicit(&w->range, &r, KB_RANGE(KB_RANGE_BEGIN(r) + 1u, KB_RANGE_END(r)),
+                                                  memory_order_acquire, memory_order_relaxed))
+        {
+            *idx = KB_RANGE_BEGIN(r);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* 从其他线程的队尾窃取一半，放进自己（已空）的队列 */
+static int kb_sched_steal(kb_sched_t *s, uint32_t self)
+{
+    uint32_t i;
+
+    for (i = 1u; i < s->workers; i++)
+    {
+        kb_sched_worker_t *v = &s->worker[(self + i) % s->workers];
+        uint64_t r = atomic_load_explicit(&v->range, memory_order_relaxed);
+
+        while (KB_RANGE_BEGIN(r) < KB_RANGE_END(r))
+        {
+            uint32_t len = KB_RANGE_END(r) - KB_RANGE_BEGIN(r);
+            uint32_t cut = KB_RANGE_END(r) - (len + 1u) / 2u;
+
+            if (atomic_compare_exchange_weak_explicit(&v->range, &r, KB_RANGE(KB_RANGE_BEGIN(r), cut),
+                                                      memory_order_acquire, memory_order_relaxed))
+            {
+                atomic_store_explicit(&s->worker[self].range, KB_RANGE(cut, KB_RANGE_END(r)), memory_order_release);
+                s->worker[self].stolen++;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void kb_sched_run(kb_sched_t *s, uint32_t self)
+{
+    kb_sched_worker_t *w = &s->worker[self];
+    uint32_t idx;
+
+    for (;;)
+    {
+        while (kb_sched_pop(w, &idx))
+        {
+            keyboard_poll(s->ctls[idx], s->dt_ms);
+            w->polled++;
+        }
+        if (!kb_sched_steal(s, self))
+        {
+            break;
+        }
+    }
+}
+
+static void *kb_sched_thread(void *arg)
+{
+    kb_sched_worker_t *w = (kb_sched_worker_t *)arg;
+    kb_sched_t *s = w->owner;
+    uint32_t self = (uint32_t)(w - &s->worker[0]);
+    uint32_t seen = 0u;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&s->lock);
+        while (s->round == seen && !s->quit)
+        {
+            pthread_cond_wait(&s->start_cv, &s->lock);
+        }
+        seen = s->round;
+        if (s->quit)
+        {
+            pthread_mutex_unlock(&s->lock);
+            break;
+        }
+        pthread_mutex_unlock(&s->lock);
+
+        kb_sched_run(s, self);
+
+        pthread_mutex_lock(&s->lock);
+        if (--s->running == 0u)
+        {
+            pthread_cond_signal(&s->done_cv);
+        }
+        pthread_mutex_unlock(&s->lock);
+    }
+    return NULL;
+}
+
+int kb_sched_init(kb_sched_t *s, keyboard_control_t **ctls, uint32_t num, uint32_t workers)
+{
+    uint32_t i;
+
+    if (s == NULL || (ctls == NULL && num != 0u))
+    {
+        return KB_ERR_PARAM;
+    }
+    if (workers == 0u)
+    {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = (n > 0) ? (uint32_t)n : 1u;
+    }
+    if (workers > KB_SCHED_MAX_WORKERS)
+    {
+        workers = KB_SCHED_MAX_WORKERS;
+    }
+
+    memset(s, 0, sizeof(*s));
+    s->ctls = ctls;
+    s->num = num;
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->start_cv, NULL);
+    pthread_cond_init(&s->done_cv, NULL);
+
+    s->workers = 1u;
+    s->worker[0].owner = s;
+    for (i = 1u; i < workers; i++)
+    {
+        s->worker[i].owner = s;
+        if (pthread_create(&s->tid[i], NULL, kb_sched_thread, &s->worker[i]) != 0)
+        {
+            break;
+        }
+        s->workers++;
+    }
+    return KB_OK;
+}
+
+void kb_sched_poll(kb_sched_t *s, uint32_t dt_ms)
+{
+    uint32_t i;
+
+    s->dt_ms = dt_ms;
+    for (i = 0u; i < s->workers; i++)
+    {
+        uint32_t b = (uint32_t)((uint64_t)s->num * i / s->workers);
+        uint32_t e = (uint32_t)((uint64_t)s->num * (i + 1u) / s->workers);
+
+        atomic_store_explicit(&s->worker[i].range, KB_RANGE(b, e), memory_order_relaxed);
+    }
+
+    /* 互斥锁同时保证上面的分配对各线程可见、本轮的回调结果对调用者可见 */
+    pthread_mutex_lock(&s->lock);
+    s->running = s->workers - 1u;
+    s->round++;
+    pthread_cond_broadcast(&s->start_cv);
+    pthread_mutex_unlock(&s->lock);
+
+    kb_sched_run(s, 0u);
+
+    pthread_mutex_lock(&s->lock);
+    while (s->running != 0u)
+    {
+        pthread_cond_wait(&s->done_cv, &s->lock);
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+void kb_sched_deinit(kb_sched_t *s)
+{
+    uint32_t i;
+
+    pthread_mutex_lock(&s->lock);
+    s->quit = 1;
+    pthread_cond_broadcast(&s->start_cv);
+    pthread_mutex_unlock(&s->lock);
+
+    for (i = 1u; i < s->workers; i++)
+    {
+        pthread_join(s->tid[i], NULL);
+    }
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->start_cv);
+    pthread_cond_destroy(&s->done_cv);
+}
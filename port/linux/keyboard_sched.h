@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+#ifndef MYCOMPONENTS_KEYBOARD_PORT_LINUX_KEYBOARD_SCHED_H_
+#define MYCOMPONENTS_KEYBOARD_PORT_LINUX_KEYBOARD_SCHED_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "keyboard_driver.h"
+
+/*
+ * 多实例并行轮询（Linux 测试台，每个被测设备一个 keyboard_control_t）
+ *
+ * kb_sched_poll() 把全部实例均分给各工作线程，线程做完自己的部分后从其他线程的队尾窃取一半，
+ * 所有实例都轮询完才返回。同一实例在一轮里只被一个线程轮询，轮与轮之间有屏障，
+ * 因此每个实例的事件顺序不变；不同实例的回调会在不同线程上并发执行。
+ */
+#define KB_SCHED_MAX_WORKERS 64u
+
+struct kb_sched;
+
+typedef struct
+{
+    struct kb_sched *owner;
+    /* 低 32 位: 下一个待轮询的实例下标；高 32 位: 结束下标 */
+    _Atomic uint64_t range;
+    uint64_t polled;          /* 累计轮询的实例数 */
+    uint64_t stolen;          /* 累计窃取次数 */
+} __attribute__((aligned(64))) kb_sched_worker_t;
+
+typedef struct kb_sched
+{
+    keyboard_control_t **ctls;
+    uint32_t num;
+    uint32_t workers;         /* 含调用线程 */
+    uint32_t dt_ms;
+    int quit;
+    uint32_t round;           /* 轮次，工作线程据此开始新一轮 */
+    uint32_t running;         /* 本轮尚未完成的工作线程数 */
+    pthread_mutex_t lock;
+    pthread_cond_t start_cv;
+    pthread_cond_t done_cv;
+    pthread_t tid[KB_SCHED_MAX_WORKERS];
+    kb_sched_worker_t worker[KB_SCHED_MAX_WORKERS];
+} kb_sched_t;
+
+/* workers 为 0 时使用在线 CPU 数；调用线程也参与轮询。线程创建失败时以已创建的线程数运行 */
+int kb_sched_init(kb_sched_t *s, keyboard_control_t **ctls, uint32_t num, uint32_t workers);
+
+/* 并行轮询全部实例一次，全部完成后返回 */
+void kb_sched_poll(kb_sched_t *s, uint32_t dt_ms);
+
+void kb_sched_deinit(kb_sched_t *s);
+
+#endif /* MYCOMPONENTS_KEYBOARD_PORT_LINUX_KEYBOARD_SCHED_H_ */
@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "keyboard_shmring.h"
+
+static size_t kb_shmring_size(uint32_t slot_count)
+{
+    return sizeof(kb_shmring_hdr_t) + (size_t)slot_count * sizeof(kb_shmring_slot_t);
+}
+
+/* 映射在多个进程间共享，不能使用 FUTEX_PRIVATE_FLAG */
+static int kb_shmring_futex(_Atomic uint32_t *uaddr, int op, uint32_t val, const struct timespec *ts)
+{
+    return (int)syscall(SYS_futex, (uint32_t *)uaddr, op, val, ts, NULL, 0);
+}
+
+static uint64_t kb_shmring_pack(const kb_shmring_rec_t *rec)
+{
+    return (uint64_t)rec->key_id | ((uint64_t)rec->evt << 16) | ((uint64_t)rec->flags << 24) |
+           ((uint64_t)rec->time_ms << 32);
+}
+
+static void kb_shmring_unpack(uint64_t d, kb_shmring_rec_t *rec)
+{
+    rec->key_id = (uint16_t)d;
+    rec->evt = (uint8_t)(d >> 16);
+    rec->flags = (uint8_t)(d >> 24);
+    rec->time_ms = (uint32_t)(d >> 32);
+}
+
+/* 废弃映射中的环：epoch 置 0 后唤醒所有等待者，让它们读完剩余记录后发现重启。返回原 epoch */
+static uint32_t kb_shmring_retire(kb_shmring_hdr_t *hdr)
+{
+    uint32_t epoch = atomic_exchange(&hdr->epoch, 0u);
+
+    atomic_fetch_add(&hdr->notify, 1u);
+    (void)kb_shmring_futex(&hdr->notify, FUTEX_WAKE, INT_MAX, NULL);
+    return epoch;
+}
+
+/* 废弃同名的旧对象（上一次运行留下的），只映射头部，不改变对象大小。返回其 epoch，没有时返回 0 */
+static uint32_t kb_shmring_retire_name(const char *name)
+{
+    kb_shmring_hdr_t *hdr;
+    struct stat st;
+    uint32_t epoch = 0u;
+    int fd;
+
+    fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0)
+    {
+        return 0u;
+    }
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(kb_shmring_hdr_t))
+    {
+        close(fd);
+        return 0u;
+    }
+    hdr = (kb_shmring_hdr_t *)mmap(NULL, sizeof(kb_shmring_hdr_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (hdr == MAP_FAILED)
+    {
+        return 0u;
+    }
+    if (hdr->magic == KB_SHMRING_MAGIC && hdr->version == KB_SHMRING_VERSION)
+    {
+        epoch = kb_shmring_retire(hdr);
+    }
+    munmap(hdr, sizeof(kb_shmring_hdr_t));
+    return epoch;
+}
+
+int kb_shmring_create(kb_shmring_pub_t *pub, const char *name, uint32_t slot_count)
+{
+    kb_shmring_hdr_t *hdr;
+    uint32_t epoch;
+    size_t len;
+    uint32_t i;
+    int fd;
+
+    if (pub == NULL || name == NULL || strlen(name) >= sizeof(pub->name) ||
+        slot_count == 0u || (slot_count & (slot_count - 1u)) != 0u)
+    {
+        return KB_ERR_PARAM;
+    }
+
+    memset(pub, 0, sizeof(*pub));
+    len = kb_shmring_size(slot_count);
+
+    /*
+     * 旧对象不能截断或复用：仍映射它的消费者会因 SIGBUS 崩溃，或因 write_seq 归零而停在旧游标上。
+     * 先通知旧消费者，再删除名字并新建，旧映射继续指向已废弃的对象
+     */
+    epoch = kb_shmring_retire_name(name) + 1u;
+    if (epoch == 0u)
+    {
+        epoch = 1u;
+    }
+    (void)shm_unlink(name);
+
+    /* 消费者需要写 waiters，因此组内可写 */
+    fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0660);
+    if (fd < 0)
+    {
+        return KB_ERR_BACKEND;
+    }
+    if (ftruncate(fd, (off_t)len) != 0)
+    {
+        close(fd);
+        shm_unlink(name);
+        return KB_ERR_NOMEM;
+    }
+    hdr = (kb_shmring_hdr_t *)mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (hdr == MAP_FAILED)
+    {
+        shm_unlink(name);
+        return KB_ERR_NOMEM;
+    }
+
+    hdr->version = KB_SHMRING_VERSION;
+    hdr->slot_count = slot_count;
+    atomic_init(&hdr->epoch, epoch);
+    atomic_init(&hdr->write_seq, 0u);
+    atomic_init(&hdr->notify, 0u);
+    atomic_init(&hdr->waiters, 0u);
+    pub->slot = (kb_shmring_slot_t *)(hdr + 1);
+    for (i = 0u; i < slot_count; i++)
+    {
+        atomic_init(&pub->slot[i].seq, 0u);
+        atomic_init(&pub->slot[i].data, 0u);
+    }
+    /* magic 最后写入，消费者看到 magic 时其余字段已就绪 */
+    atomic_thread_fence(memory_order_release);
+    hdr->magic = KB_SHMRING_MAGIC;
+
+    pub->hdr = hdr;
+    pub->mask = slot_count - 1u;
+    pub->map_len = len;
+    memcpy(pub->name, name, strlen(name) + 1u);
+
+    return KB_OK;
+}
+
+void kb_shmring_on_event(const char *keyname, uint16_t key_id, kb_event_t evt, void *user)
+{
+    kb_shmring_pub_t *pub = (kb_shmring_pub_t *)user;
+    kb_shmring_slot_t *slot;
+    kb_shmring_rec_t rec;
+    struct timespec ts;
+    uint64_t seq;
+
+    (void)keyname;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    rec.key_id = key_id;
+    rec.evt = (uint8_t)evt;
+    rec.flags = 0u;
+    rec.time_ms = (uint32_t)((uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u);
+
+    /* 单写者序列锁：seq 置 0 -> 写数据 -> seq = 序号 + 1 */
+    seq = atomic_load_explicit(&pub->hdr->write_seq, memory_order_relaxed);
+    slot = &pub->slot[seq & pub->mask];
+    atomic_store_explicit(&slot->seq, 0u, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&slot->data, kb_shmring_pack(&rec), memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 1u, memory_order_release);
+    atomic_store_explicit(&pub->hdr->write_seq, seq + 1u, memory_order_release);
+}
+
+void kb_shmring_publish(kb_shmring_pub_t *pub)
+{
+    uint64_t seq = atomic_load_explicit(&pub->hdr->write_seq, memory_order_relaxed);
+
+    if (seq == pub->notified_seq)
+    {
+        return;
+    }
+    pub->notified_seq = seq;
+
+    /* 先改 futex 字再看 waiters：刚开始等待的消费者要么看到新值不睡，要么已计入 waiters */
+    atomic_fetch_add(&pub->hdr->notify, 1u);
+    if (atomic_load(&pub->hdr->waiters) != 0u)
+    {
+        (void)kb_shmring_futex(&pub->hdr->notify, FUTEX_WAKE, INT_MAX, NULL);
+    }
+}
+
+void kb_shmring_destroy(kb_shmring_pub_t *pub)
+{
+    if (pub == NULL || pub->hdr == NULL)
+    {
+        return;
+    }
+    (void)kb_shmring_retire(pub->hdr);
+    munmap(pub->hdr, pub->map_len);
+    shm_unlink(pub->name);
+    pub->hdr = NULL;
+}
+
+int kb_shmring_open(kb_shmring_sub_t *sub, const char *name)
+{
+    kb_shmring_hdr_t *hdr;
+    struct stat st;
+    int fd;
+
+    if (sub == NULL || name == NULL)
+    {
+        return KB_ERR_PARAM;
+    }
+    memset(sub, 0, sizeof(*sub));
+
+    fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0)
+    {
+        return KB_ERR_BACKEND;
+    }
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(kb_shmring_hdr_t))
+    {
+        close(fd);
+        return KB_ERR_BACKEND;
+    }
+    hdr = (kb_shmring_hdr_t *)mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (hdr == MAP_FAILED)
+    {
+        return KB_ERR_NOMEM;
+    }
+
+    if (hdr->magic != KB_SHMRING_MAGIC || hdr->version != KB_SHMRING_VERSION ||
+        hdr->slot_count == 0u || (hdr->slot_count & (hdr->slot_count - 1u)) != 0u ||
+        kb_shmring_size(hdr->slot_count) > (size_t)st.st_size ||
+        atomic_load(&hdr->epoch) == 0u)
+    {
+        munmap(hdr, (size_t)st.st_size);
+        return KB_ERR_BACKEND;
+    }
+    atomic_thread_fence(memory_order_acquire);
+
+    sub->hdr = hdr;
+    sub->slot = (const kb_shmring_slot_t *)(hdr + 1);
+    sub->mask = hdr->slot_count - 1u;
+    sub->map_len = (size_t)st.st_size;
+    sub->epoch = atomic_load(&hdr->epoch);
+    sub->cursor = atomic_load_explicit(&hdr->write_seq, memory_order_acquire);
+
+    return KB_OK;
+}
+
+int kb_shmring_read(kb_shmring_sub_t *sub, kb_shmring_rec_t *rec)
+{
+    for (;;)
+    {
+        /* epoch 先于 write_seq 读取：看到 0 时，废弃前写入的记录都已可见 */
+        uint32_t epoch = atomic_load_explicit(&sub->hdr->epoch, memory_order_acquire);
+        uint64_t w = atomic_load_explicit(&sub->hdr->write_seq, memory_order_acquire);
+        const kb_shmring_slot_t *slot;
+        uint64_t s1;
+        uint64_t s2;
+        uint64_t d;
+
+        if (sub->cursor >= w)
+        {
+            /* 剩余记录读完后才报告重启 */
+            return (epoch == sub->epoch) ? 0 : KB_ERR_BACKEND;
+        }
+        if (w - sub->cursor > (uint64_t)sub->mask + 1u)
+        {
+            /* 落后超过一圈，跳到仍然有效的最旧记录 */
+            sub->lost += w - ((uint64_t)sub->mask + 1u) - sub->cursor;
+            sub->cursor = w - ((uint64_t)sub->mask + 1u);
+        }
+
+        slot = &sub->slot[sub->cursor & sub->mask];
+        s1 = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        d = atomic_load_explicit(&slot->data, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        s2 = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+
+        if (s1 == sub->cursor + 1u && s2 == s1)
+        {
+            kb_shmring_unpack(d, rec);
+            sub->cursor++;
+            return 1;
+        }
+        /* 读的同时被覆盖：重新读取 write_seq，按落后处理 */
+    }
+}
+
+int kb_shmring_wait(kb_shmring_sub_t *sub, kb_shmring_rec_t *rec, int timeout_ms)
+{
+    struct timespec deadline;
+    struct timespec now;
+    struct timespec rel;
+
+    if (timeout_ms >= 0)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    for (;;)
+    {
+        uint32_t v = atomic_load_explicit(&sub->hdr->notify, memory_order_acquire);
+        int ret = kb_shmring_read(sub, rec);
+
+        if (ret != 0)
+        {
+            return ret;
+        }
+        if (timeout_ms >= 0)
+        {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            rel.tv_sec = deadline.tv_sec - now.tv_sec;
+            rel.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if (rel.tv_nsec < 0)
+            {
+                rel.tv_sec--;
+                rel.tv_nsec += 1000000000L;
+            }
+            if (rel.tv_sec < 0)
+            {
+                return 0;
+            }
+        }
+
+        /* notify 在 v 之后变化过则立即返回，不会错过唤醒 */
+        atomic_fetch_add(&sub->hdr->waiters, 1u);
+        (void)kb_shmring_futex(&sub->hdr->notify, FUTEX_WAIT, v, (timeout_ms >= 0) ? &rel : NULL);
+        atomic_fetch_sub(&sub->hdr->waiters, 1u);
+    }
+}
+
+void kb_shmring_close(kb_shmring_sub_t *sub)
+{
+    if (sub == NULL || sub->hdr == NULL)
+    {
+        return;
+    }
+    munmap(sub->hdr, sub->map_len);
+    sub->hdr = NULL;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+#ifndef MYCOMPONENTS_KEYBOARD_PORT_LINUX_KEYBOARD_SHMRING_H_
+#define MYCOMPONENTS_KEYBOARD_PORT_LINUX_KEYBOARD_SHMRING_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "keyboard_driver.h"
+
+/*
+ * 共享内存广播环（单生产者、任意多消费者进程）
+ *
+ * 扫描进程把事件写成 8 字节的紧凑记录放进 POSIX 共享内存中的环形缓冲，从不等待消费者；
+ * 每个消费者持有自己的读游标，读取只有原子加载，没有系统调用。
+ * 消费者落后超过一圈时直接跳到最旧的有效记录，并累计丢失数。
+ *
+ * 无数据时消费者可以在共享的 futex 字上睡眠；生产者每次 poll 后调用一次 kb_shmring_publish()，
+ * 只有存在等待者时才会进入内核唤醒。
+ *
+ * 生产者重启时不会改动旧对象的内容：先把旧对象的 epoch 置 0 并唤醒等待者，再 shm_unlink，
+ * 然后以 O_EXCL 新建。仍映射旧对象的消费者读完剩余记录后得到 KB_ERR_BACKEND，
+ * 应 kb_shmring_close() 后重新 kb_shmring_open()；生产者正常退出（kb_shmring_destroy）时同样处理。
+ */
+#define KB_SHMRING_MAGIC   0x4B425352u   /* "KBSR" */
+#define KB_SHMRING_VERSION 2u
+
+/* 记录：key_id | evt | flags | time_ms（CLOCK_MONOTONIC 毫秒，32 位回绕） */
+typedef struct
+{
+    uint16_t key_id;
+    uint8_t evt;              /* kb_event_t */
+    uint8_t flags;            /* 保留 */
+    uint32_t time_ms;
+} kb_shmring_rec_t;
+
+/* 槽位：seq 为 “记录序号 + 1”，0 表示正在写入 */
+typedef struct
+{
+    _Atomic uint64_t seq;
+    _Atomic uint64_t data;
+} kb_shmring_slot_t;
+
+/* 共享内存头，后接 slot_count 个槽位 */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;      /* 2 的幂 */
+    _Atomic uint32_t epoch;   /* 生产者代数，每次创建加 1；0 表示已被废弃 */
+    _Atomic uint64_t write_seq __attribute__((aligned(64)));   /* 下一条记录的序号 */
+    _Atomic uint32_t notify __attribute__((aligned(64)));      /* futex 字，每次 publish 加 1 */
+    _Atomic uint32_t waiters;
+} kb_shmring_hdr_t;
+
+/* 生产者（扫描进程） */
+typedef struct
+{
+    kb_shmring_hdr_t *hdr;
+    kb_shmring_slot_t *slot;
+    uint32_t mask;
+    uint64_t notified_seq;    /* 上次 publish 时的 write_seq */
+    size_t map_len;
+    char name[64];
+} kb_shmring_pub_t;
+
+/* 消费者（每个进程/线程一个） */
+typedef struct
+{
+    kb_shmring_hdr_t *hdr;    /* 消费者只写 waiters */
+    const kb_shmring_slot_t *slot;
+    uint32_t mask;
+    uint64_t cursor;          /* 下一条要读的序号 */
+    uint64_t lost;            /* 因落后被覆盖而丢失的记录数 */
+    uint32_t epoch;           /* 打开时的生产者代数 */
+    size_t map_len;
+} kb_shmring_sub_t;
+
+/* 创建共享内存（name 形如 "/keyboard"），slot_count 必须为 2 的幂；同名的旧对象先被废弃并删除 */
+int kb_shmring_create(kb_shmring_pub_t *pub, const char *name, uint32_t slot_count);
+
+/* keyboard 事件回调，user 传入 kb_shmring_pub_t *；写入后对消费者立即可见 */
+void kb_shmring_on_event(const char *keyname, uint16_t key_id, kb_event_t evt, void *user);
+
+/* 每次 poll 后调用：有新记录且有消费者在睡眠时唤醒它们 */
+void kb_shmring_publish(kb_shmring_pub_t *pub);
+
+void kb_shmring_destroy(kb_shmring_pub_t *pub);
+
+/* 打开共享内存，游标从当前位置开始（只接收之后的事件）；对象已被废弃时返回 KB_ERR_BACKEND */
+int kb_shmring_open(kb_shmring_sub_t *sub, const char *name);
+
+/* 非阻塞读取一条记录：成功返回 1，无新记录返回 0，生产者已重启或退出返回 KB_ERR_BACKEND。无系统调用 */
+int kb_shmring_read(kb_shmring_sub_t *sub, kb_shmring_rec_t *rec);
+
+/* 阻塞读取，timeout_ms < 0 表示一直等待：成功返回 1，超时返回 0，生产者已重启或退出返回 KB_ERR_BACKEND */
+int kb_shmring_wait(kb_shmring_sub_t *sub, kb_shmring_rec_t *rec, int timeout_ms);
+
+void kb_shmring_close(kb_shmring_sub_t *sub);
+
+#endif /* MYCOMPONENTS_KEYBOARD_PORT_LINUX_KEYBOARD_SHMRING_H_ */
@@ -9,29 +9,65 @@
  */
 
 #include "keyboard_driver.h"
+#if KB_USING_TRACE
+#include "keyboard_trace.h"
+#endif
+#if KB_USING_BSP_INLINE
+#include "keyboard_bsp.h"
+#endif
 
-static uint8_t key_pool_buf[KEYBOARD_POOL_SIZE];
-static mpool_t key_pool;
+#define KB_PENDING_EVT_MAX ((uint16_t)KB_PENDING_EVT_LEN)
 
+/* 单次 poll 的待发事件，全部判定完成后统一回调 */
 typedef struct
 {
-    uint8_t raw_last;
-    uint8_t stable;
-    uint8_t long_sent;
-    uint8_t click_count;
-    uint32_t debounce_ms;
-    uint32_t press_ms;
-    uint32_t repeat_ms;
-    uint32_t click_wait_ms;
-} kb_key_runtime_t;
+    keyboard_control_t *ctl;
+    uint16_t evt_num;
+#if KB_HAS_BACKEND(KB_BACKEND_GPIO)
+    uint32_t port_val[KB_GPIO_MAX_PORTS];  /* 本次 poll 已读端口的值 */
+    uint32_t port_read;                    /* 已读端口位图 */
+#endif
+#if KB_USING_GPIO_IRQ
+    uint32_t dirty[KB_GPIO_DIRTY_WORDS];   /* 本次 poll 取走的脏引脚 */
+#endif
+#if KB_USING_TIMESTAMP
+    uint32_t at_us;                        /* 判定所在时刻：通常为 now_us，输入捕获补推计时时为边沿确认时刻 */
+#endif
+    kb_pending_evt_t *evt;                 /* 即 ctl->pending_evt，不占 poll 的栈 */
+} kb_poll_ctx_t;
 
-typedef struct
-{
-    const keyboard_que_t *node;
-    kb_event_t evt;
-} kb_pending_evt_t;
+/* 硬件访问：默认经 keyboard_ops_t 间接调用，BSP 内联绑定时直接展开 keyboard_bsp.h 中的 KB_OP_xxx */
+#if KB_USING_BSP_INLINE
+#if (KB_BACKEND_MODE == KB_BACKEND_GPIO) && KB_FIXED_GPIO_PORT && !defined(KB_OP_READ_PORT)
+#error "keyboard_bsp.h must define KB_OP_READ_PORT(port)"
+#elif (KB_BACKEND_MODE == KB_BACKEND_GPIO) && !KB_FIXED_GPIO_PORT && !defined(KB_OP_READ_PIN)
+#error "keyboard_bsp.h must define KB_OP_READ_PIN(pin)"
+#elif (KB_BACKEND_MODE == KB_BACKEND_MATRIX) && \
+    (!defined(KB_OP_MATRIX_SELECT_ROW) || !defined(KB_OP_MATRIX_READ_COL) || !defined(KB_OP_MATRIX_UNSELECT_ROW))
+#error "keyboard_bsp.h must define KB_OP_MATRIX_SELECT_ROW/READ_COL/UNSELECT_ROW"
+#elif (KB_BACKEND_MODE == KB_BACKEND_CUSTOM) && !defined(KB_OP_SCAN_SNAPSHOT)
+#error "keyboard_bsp.h must define KB_OP_SCAN_SNAPSHOT(buf, count)"
+#endif
+#define KB_HW_READ_PIN(ctl, pin)            KB_OP_READ_PIN(pin)
+#define KB_HW_READ_PORT(ctl, port)          KB_OP_READ_PORT(port)
+#define KB_HW_SELECT_ROW(ctl, row)          KB_OP_MATRIX_SELECT_ROW(row)
+#define KB_HW_READ_COL(ctl, col)            KB_OP_MATRIX_READ_COL(col)
+#define KB_HW_UNSELECT_ROW(ctl, row)        KB_OP_MATRIX_UNSELECT_ROW(row)
+#define KB_HW_SCAN_SNAPSHOT(ctl, buf, n)    KB_OP_SCAN_SNAPSHOT(buf, n)
+#else
+#define KB_HW_READ_PIN(ctl, pin)            ((ctl)->keyboard_ops.read_pin(pin))
+#define KB_HW_READ_PORT(ctl, port)          ((ctl)->keyboard_ops.read_port(port))
+#define KB_HW_SELECT_ROW(ctl, row)          ((ctl)->keyboard_ops.matrix_select_row(row))
+#define KB_HW_READ_COL(ctl, col)            ((ctl)->keyboard_ops.matrix_read_col(col))
+#define KB_HW_UNSELECT_ROW(ctl, row)        ((ctl)->keyboard_ops.matrix_unselect_row(row))
+#define KB_HW_SCAN_SNAPSHOT(ctl, buf, n)    ((ctl)->keyboard_ops.scan_snapshot((buf), (n)))
+#endif
 
-static kb_key_runtime_t key_rt[KB_MAX_KEYS];
+#if KB_USING_SIMD
+#define KB_RAW_BUF_LEN KB_SIMD_KEYS
+#else
+#define KB_RAW_BUF_LEN KB_MAX_KEYS
+#endif
 
 static int kb_hw_equal(uint8_t backend_mode, const keyboard_hw_ref_t *a, const keyboard_hw_ref_t *b)
 {
@@ -52,379 +88,1819 @@ static int kb_hw_equal(uint8_t backend_mode, const keyboard_hw_ref_t *a, const k
     }
 }
 
-static void kb_emit_event(keyboard_control_t *ctl, const keyboard_que_t *node, kb_event_t evt)
+#if KB_USING_HYBRID
+#define KB_KEY_BACKEND(ctl, node) ((node)->backend)
+
+/* 后端所需的操作是否齐全（注册时检查） */
+static uint8_t kb_backend_ready(const keyboard_ops_t *ops, uint8_t backend)
 {
-    if (ctl == NULL || node == NULL)
-    {
-        return;
-    }
-    if (ctl->keyboard_cb.on_event != NULL)
+    switch (backend)
     {
-        ctl->keyboard_cb.on_event(node->keyname, node->key_id, evt, ctl->keyboard_cb.user);
+    case KB_BACKEND_GPIO:
+        return (uint8_t)(ops->read_pin != NULL || ops->read_port != NULL);
+    case KB_BACKEND_MATRIX:
+        return (uint8_t)(ops->matrix_select_row != NULL && ops->matrix_read_col != NULL &&
+                         ops->matrix_unselect_row != NULL);
+    case KB_BACKEND_CUSTOM:
+        return (uint8_t)(ops->scan_snapshot != NULL);
+    default:
+        return 0u;
     }
 }
+#else
+#define KB_KEY_BACKEND(ctl, node) KB_CTL_BACKEND(ctl)
+#endif
+
+/* 实例的后端：固定后端时为编译期常量，相关分支由编译器折叠 */
+#if KB_USING_FIXED_BACKEND
+#define KB_CTL_BACKEND(ctl) ((uint8_t)KB_BACKEND_MODE)
+#else
+#define KB_CTL_BACKEND(ctl) ((ctl)->backend_mode)
+#endif
 
-static uint8_t kb_read_raw(const keyboard_control_t *ctl, const keyboard_que_t *node, uint8_t index, const uint8_t *snapshot)
+#if KB_USING_EVENT_QUEUE
+#if KB_USING_REPEAT_COALESCE
+/* 该按键在队列中最新的一条记录若是未取走的连发，则合并进去；调用者持锁 */
+static uint8_t kb_evt_coalesce(keyboard_control_t *ctl, const keyboard_event_t *e)
 {
-    if (ctl == NULL || node == NULL)
-    {
-        return 0u;
-    }
+    uint16_t i = ctl->evt_tail;
 
-    switch (ctl->backend_mode)
+    while (i != ctl->evt_head)
     {
-    case KB_BACKEND_GPIO:
-        if (ctl->keyboard_ops.read_pin == NULL)
-        {
-            return 0u;
-        }
-        return (uint8_t)((ctl->keyboard_ops.read_pin(node->hw.gpio_pin) == KB_GPIO_ACTIVE_LEVEL) ? 1u : 0u);
+        keyboard_event_t *q;
 
-    case KB_BACKEND_MATRIX:
-        if (ctl->keyboard_ops.matrix_select_row == NULL ||
-            ctl->keyboard_ops.matrix_read_col == NULL ||
-            ctl->keyboard_ops.matrix_unselect_row == NULL)
+        i--;
+        q = &ctl->evt_queue[i & (KB_EVENT_QUEUE_LEN - 1u)];
+        if (q->key_idx != e->key_idx)
         {
-            return 0u;
+            continue;
         }
-        ctl->keyboard_ops.matrix_select_row(node->hw.matrix.row);
+        if (q->evt != KB_EVT_REPEAT)
         {
-            uint8_t level = (uint8_t)ctl->keyboard_ops.matrix_read_col(node->hw.matrix.col);
-            ctl->keyboard_ops.matrix_unselect_row(node->hw.matrix.row);
-            return (uint8_t)((level == KB_MATRIX_ACTIVE_LEVEL) ? 1u : 0u);
+            return 0u;
         }
-
-    case KB_BACKEND_CUSTOM:
-    default:
-        if (snapshot == NULL || index >= KB_MAX_KEYS)
+        q->repeat_count = e->repeat_count;
+#if KB_USING_TIMESTAMP
+        q->time_us = e->time_us;
+#endif
+        if (q->count < 0xFFFFu)
         {
-            return 0u;
+            q->count++;
         }
-        return (uint8_t)(snapshot[index] ? 1u : 0u);
+        return 1u;
     }
+    return 0u;
 }
+#endif
 
-
-int keyboard_init(keyboard_control_t *ctl, const keyboard_ops_t *ops, const keyboard_cb_t *cb)
+/*
+ * 事件入队（只在 poll 中调用），返回 1 表示成功。
+ * 槽位写完后再以 release 发布 evt_tail，不需要锁；连发合并要改写已入队的记录，此时与消费者之间用 lock/unlock 保护
+ */
+static uint8_t kb_evt_enqueue(keyboard_control_t *ctl, const keyboard_event_t *e)
 {
-    uint16_t stride;
-    uint16_t count;
-
-    if (ctl == NULL || ops == NULL)
-    {
-        return KB_ERR_PARAM;
-    }
+    uint16_t tail = ctl->evt_tail;
+    uint8_t ok = 0u;
 
-#if (KB_BACKEND_MODE == KB_BACKEND_GPIO)
-    if (ops->read_pin == NULL)
+#if KB_USING_REPEAT_COALESCE
+    if (ctl->keyboard_ops.lock != NULL)
     {
-        return KB_ERR_BACKEND;
+        ctl->keyboard_ops.lock();
     }
-#elif (KB_BACKEND_MODE == KB_BACKEND_MATRIX)
-    if (ops->matrix_select_row == NULL || ops->matrix_read_col == NULL || ops->matrix_unselect_row == NULL)
+    if (e->evt == KB_EVT_REPEAT)
     {
-        return KB_ERR_BACKEND;
+        ok = kb_evt_coalesce(ctl, e);
     }
 #endif
-
-    stride = MPOOL_ALIGN_UP((uint16_t)(sizeof(keyboard_que_t) + sizeof(mpool_node_t)));
-    count = (uint16_t)(KEYBOARD_POOL_SIZE / stride);
-
-    if (count == 0u)
+    if (ok == 0u)
     {
-        return KB_ERR_POOL_CFG;
+        /* evt_head 以 acquire 读取：消费者取走槽位内容之后才会被覆盖 */
+        if ((uint16_t)(tail - KB_ATOMIC_LOAD_ACQ16(&ctl->evt_head)) < KB_EVENT_QUEUE_LEN)
+        {
+            ctl->evt_queue[tail & (KB_EVENT_QUEUE_LEN - 1u)] = *e;
+            KB_ATOMIC_STORE_REL16(&ctl->evt_tail, (uint16_t)(tail + 1u));
+            ok = 1u;
+        }
+        else
+        {
+            ctl->evt_queue_dropped++;
+        }
     }
-    if (count > KB_MAX_KEYS)
+#if KB_USING_REPEAT_COALESCE
+    if (ctl->keyboard_ops.unlock != NULL)
     {
-        count = KB_MAX_KEYS;
+        ctl->keyboard_ops.unlock();
     }
+#endif
+    return ok;
+}
+#endif
 
-    mpool_init(&key_pool, key_pool_buf, (uint16_t)sizeof(keyboard_que_t), count);
-
-    ctl->backend_mode = (uint8_t)KB_BACKEND_MODE;
-    ctl->keyboard_ops = *ops;
-    ctl->keyboard_cb.on_event = (cb != NULL) ? cb->on_event : NULL;
-    ctl->keyboard_cb.user = (cb != NULL) ? cb->user : NULL;
-    ctl->head = NULL;
-    ctl->key_num = 0;
-    ctl->keyboard_pool = &key_pool;
-    memset(key_rt, 0, sizeof(key_rt));
-
-    return KB_OK;
+#if KB_USING_DEFERRED_DISPATCH
+static uint32_t kb_cb_time_start(const keyboard_control_t *ctl)
+{
+    return (ctl->keyboard_ops.get_tick_us != NULL) ? ctl->keyboard_ops.get_tick_us() : 0u;
 }
 
-int keyboard_register_key(const keyboard_key_cfg_t *cfg, keyboard_control_t *ctl)
+/* 统计一次回调的耗时，超过预算时记录并通知 */
+static void kb_cb_time_check(keyboard_control_t *ctl, const keyboard_event_t *e, uint32_t t0)
 {
-    keyboard_que_t *node;
-    keyboard_que_t *tail;
+    uint32_t cost;
 
-    if (ctl == NULL || cfg == NULL || cfg->keyname == NULL || ctl->keyboard_pool == NULL)
+    if (ctl->keyboard_ops.get_tick_us == NULL)
     {
-        return KB_ERR_PARAM;
+        return;
     }
-
-    if (ctl->backend_mode == KB_BACKEND_MATRIX)
+    cost = ctl->keyboard_ops.get_tick_us() - t0;
+    if (cost > ctl->cb_max_us)
     {
-        if (cfg->hw.matrix.row >= KB_MATRIX_MAX_ROW || cfg->hw.matrix.col >= KB_MATRIX_MAX_COL)
+        ctl->cb_max_us = cost;
+    }
+    if (cost > ctl->cb_budget_us)
+    {
+        ctl->cb_overrun++;
+        ctl->cb_overrun_evt = *e;
+        if (ctl->keyboard_cb.on_overrun != NULL)
         {
-            return KB_ERR_RANGE;
+            ctl->keyboard_cb.on_overrun(e, cost, ctl->keyboard_cb.user);
         }
     }
+}
+#endif
 
-    if (ctl->keyboard_ops.lock != NULL)
-    {
-        ctl->keyboard_ops.lock();
-    }
+#if KB_USING_SUBSCRIBER
+/*
+ * 无锁复制关心该事件的订阅者回调；事件类型已在预计算的列表中过滤，这里只剩按键过滤。
+ * 读完后版本号未变说明复制期间没有写者改写这份表，否则重读；中断打断写者时不会重试。
+ * 被改写中的表可能读到半新半旧的下标，循环里的上限和取模只保证重读前不越界
+ */
+static uint8_t kb_sub_collect(keyboard_control_t *ctl, const keyboard_event_t *e,
+                              keyboard_sub_cb *cb, void **user)
+{
+    const kb_sub_table_t *tab;
+    uint16_t gen;
+    uint8_t num;
+    uint8_t i;
 
-    tail = ctl->head;
-    while (tail != NULL)
+    do
     {
-        if (tail->key_id == cfg->key_id || kb_hw_equal(ctl->backend_mode, &tail->hw, &cfg->hw))
+        gen = KB_ATOMIC_LOAD_ACQ16(&ctl->sub_gen);
+        tab = &ctl->sub_tab[gen & 1u];
+        num = 0u;
+        for (i = 0u; i < tab->num[e->evt] && i < KB_MAX_SUBSCRIBERS; i++)
         {
-            if (ctl->keyboard_ops.unlock != NULL)
+            const keyboard_subscriber_t *sub = &tab->sub[tab->list[e->evt][i] % KB_MAX_SUBSCRIBERS];
+
+            if (sub->on_event == NULL || e->key_id < sub->key_min || e->key_id > sub->key_max)
             {
-                ctl->keyboard_ops.unlock();
+                continue;
             }
-            return KB_ERR_DUPLICATE;
-        }
-        if (tail->next == NULL)
-        {
-            break;
+            if (sub->key_mask != NULL && (sub->key_mask[e->key_idx >> 3] & (uint8_t)(1u << (e->key_idx & 7u))) == 0u)
+            {
+                continue;
+            }
+            cb[num] = sub->on_event;
+            user[num] = sub->user;
+            num++;
         }
-        tail = tail->next;
-    }
+        KB_ATOMIC_FENCE_ACQ();
+    } while (KB_ATOMIC_LOAD_ACQ16(&ctl->sub_gen) != gen);
 
-    if (ctl->key_num >= KB_MAX_KEYS)
+    return num;
+}
+#endif
+
+/* 把一个事件交给实例回调和关心它的订阅者 */
+static void kb_deliver(keyboard_control_t *ctl, const keyboard_event_t *e)
+{
+#if KB_USING_DEFERRED_DISPATCH
+    uint32_t t0;
+#endif
+#if KB_USING_REPEAT_COALESCE
+    uint16_t n;
+#endif
+#if KB_USING_KEY_HANDLER
+    /* 函数和 user 在同一个常量对象里，一次原子读取即可成对拿到，poll 中不需要锁 */
+    const keyboard_key_handler_t *kh = KB_ATOMIC_LOAD_ACQ_PTR(&ctl->key_rt[e->key_idx].handler);
+#endif
+#if KB_USING_SUBSCRIBER
+    keyboard_sub_cb cb[KB_MAX_SUBSCRIBERS];
+    void *user[KB_MAX_SUBSCRIBERS];
+    uint8_t num;
+    uint8_t i;
+#endif
+
+#if KB_USING_KEY_HANDLER
+    if (kh != NULL)
     {
-        if (ctl->keyboard_ops.unlock != NULL)
-        {
-            ctl->keyboard_ops.unlock();
-        }
-        return KB_ERR_FULL;
+#if KB_USING_DEFERRED_DISPATCH
+        t0 = kb_cb_time_start(ctl);
+#endif
+        kh->on_event(e, kh->user);
+#if KB_USING_DEFERRED_DISPATCH
+        kb_cb_time_check(ctl, e, t0);
+#endif
     }
+#endif
 
-    node = (keyboard_que_t *)mpool_alloc(ctl->keyboard_pool);
-    if (node == NULL)
+    if (ctl->keyboard_cb.on_event != NULL)
     {
-        if (ctl->keyboard_ops.unlock != NULL)
+#if KB_USING_DEFERRED_DISPATCH
+        t0 = kb_cb_time_start(ctl);
+#endif
+#if KB_USING_REPEAT_COALESCE
+        /* 旧式回调看不到 count：合并的连发逐次回调，与不合并时的调用次数一致 */
+        for (n = 0u; n < e->count; n++)
         {
-            ctl->keyboard_ops.unlock();
+            ctl->keyboard_cb.on_event(e->keyname, e->key_id, e->evt, ctl->keyboard_cb.user);
         }
-        return KB_ERR_NOMEM;
+#else
+        ctl->keyboard_cb.on_event(e->keyname, e->key_id, e->evt, ctl->keyboard_cb.user);
+#endif
+#if KB_USING_DEFERRED_DISPATCH
+        kb_cb_time_check(ctl, e, t0);
+#endif
     }
 
-    node->keyname = cfg->keyname;
-    node->key_id = cfg->key_id;
-    node->hw = cfg->hw;
-    node->next = NULL;
-
-    if (tail == NULL)
+#if KB_USING_SUBSCRIBER
+    /* 先取出本事件的订阅者再回调：回调中（或其他任务）订阅/取消订阅不会破坏遍历 */
+    num = kb_sub_collect(ctl, e, cb, user);
+    for (i = 0u; i < num; i++)
     {
-        ctl->head = node;
+#if KB_USING_DEFERRED_DISPATCH
+        t0 = kb_cb_time_start(ctl);
+#endif
+        cb[i](e, user[i]);
+#if KB_USING_DEFERRED_DISPATCH
+        kb_cb_time_check(ctl, e, t0);
+#endif
     }
-    else
+#endif
+}
+
+static void kb_emit_event(keyboard_control_t *ctl, const kb_pending_evt_t *pe)
+{
+    keyboard_event_t e;
+
+    if (ctl == NULL || pe->node == NULL)
     {
-        tail->next = node;
+        return;
     }
-    ctl->key_num++;
 
-    if (ctl->keyboard_ops.unlock != NULL)
+    e.keyname = pe->node->keyname;
+    e.key_id = pe->node->key_id;
+    e.key_idx = pe->idx;
+    e.repeat_count = pe->repeat_count;
+    e.count = 1u;
+    e.evt = pe->evt;
+#if KB_USING_TIMESTAMP
+    e.time_us = pe->time_us;
+#endif
+#if KB_USING_DEFERRED_DISPATCH
+    (void)kb_evt_enqueue(ctl, &e);
+#elif KB_USING_EVENT_QUEUE
+    /* 没有任务等待事件时不入队，否则队列会一直满着，evt_queue_dropped 无意义地增长 */
+    if (KB_ATOMIC_LOAD_ACQ16(&ctl->evt_waiter) != 0u)
     {
-        ctl->keyboard_ops.unlock();
+        (void)kb_evt_enqueue(ctl, &e);
     }
-    return KB_OK;
+#endif
+#if !KB_USING_DEFERRED_DISPATCH
+    kb_deliver(ctl, &e);
+#endif
 }
 
-int keyboard_register_gpio(uint8_t pin, const char *key_name, uint16_t key_id, keyboard_control_t *ctl)
+/* 返回写入的记录，缓存满时返回 NULL */
+static kb_pending_evt_t *kb_pending_push(kb_poll_ctx_t *pc, const keyboard_que_t *node, uint16_t idx, kb_event_t evt)
 {
-    keyboard_key_cfg_t cfg;
+    kb_pending_evt_t *e;
 
-    cfg.keyname = key_name;
-    cfg.key_id = key_id;
-    cfg.hw.gpio_pin = pin;
+    if (pc->evt_num >= KB_PENDING_EVT_MAX)
+    {
+        pc->ctl->evt_dropped++;
+        return NULL;
+    }
 
-    return keyboard_register_key(&cfg, ctl);
+    e = &pc->evt[pc->evt_num];
+    e->node = node;
+    e->idx = idx;
+    e->repeat_count = 0u;
+    e->evt = evt;
+#if KB_USING_TIMESTAMP
+    e->time_us = pc->at_us;
+#endif
+    pc->evt_num++;
+    return e;
 }
 
-int keyboard_register_matrix(uint8_t row, uint8_t col, const char *key_name, uint16_t key_id, keyboard_control_t *ctl)
+#if KB_USING_TIMESTAMP
+static void kb_pending_at(kb_pending_evt_t *e, uint32_t time_us)
 {
-    keyboard_key_cfg_t cfg;
-
-    cfg.keyname = key_name;
-    cfg.key_id = key_id;
-    cfg.hw.matrix.row = row;
-    cfg.hw.matrix.col = col;
+    if (e != NULL)
+    {
+        e->time_us = time_us;
+    }
+}
 
-    return keyboard_register_key(&cfg, ctl);
+/* 计时器超出阈值 over_ms 才被本次 poll 发现，实际到期时刻要往前推 */
+static inline uint32_t kb_due_us(const kb_poll_ctx_t *pc, uint32_t over_ms)
+{
+    return pc->at_us - over_ms * 1000u;
 }
 
-void keyboard_poll(keyboard_control_t *ctl, uint32_t dt_ms)
+/* 按发生时刻稳定排序：同一时刻保持判定顺序；同一按键的事件不越过彼此，按下/释放配对不会颠倒 */
+static void kb_pending_sort(kb_poll_ctx_t *pc)
 {
-    keyboard_que_t *node;
-    uint8_t custom_snapshot[KB_MAX_KEYS] = {0};
-    kb_pending_evt_t pending_evt[KB_MAX_KEYS * 4u];
-    uint16_t evt_num = 0u;
-    uint16_t idx = 0u;
+    uint32_t now = pc->ctl->now_us;
+    uint16_t i;
 
-    if (ctl == NULL || dt_ms == 0u)
+    for (i = 1u; i < pc->evt_num; i++)
     {
-        return;
-    }
+        kb_pending_evt_t e = pc->evt[i];
+        uint32_t age = now - e.time_us;
+        uint16_t j = i;
 
-    if (ctl->backend_mode == KB_BACKEND_CUSTOM)
-    {
-        if (ctl->keyboard_ops.scan_snapshot == NULL)
-        {
-            return;
-        }
-        if (ctl->keyboard_ops.scan_snapshot(custom_snapshot, ctl->key_num) != 0)
+        /* 比较距本次 poll 的时长，时钟回绕不影响 */
+        while (j > 0u && pc->evt[j - 1u].idx != e.idx && (now - pc->evt[j - 1u].time_us) < age)
         {
-            return;
+            pc->evt[j] = pc->evt[j - 1u];
+            j--;
         }
+        pc->evt[j] = e;
     }
+}
 
-    node = ctl->head;
-    while (node != NULL && idx < ctl->key_num && idx < KB_MAX_KEYS)
+/* 记录原始电平离开稳定电平的时刻（在 raw_last 更新之前调用），去抖窗口内的抖动不会把它推后 */
+static void kb_note_edge(kb_key_runtime_t *rt, uint8_t raw, uint32_t now_us)
+{
+    if (raw != rt->stable && rt->raw_last == rt->stable &&
+        (rt->edge_set == 0u || (uint32_t)(now_us - rt->edge_us) >= KB_DEBOUNCE_MS * 1000u))
     {
-        kb_key_runtime_t *rt = &key_rt[idx];
-        uint8_t raw = kb_read_raw(ctl, node, (uint8_t)idx, custom_snapshot);
+        rt->edge_us = now_us;
+        rt->edge_set = 1u;
+    }
+}
 
-        if (raw != rt->raw_last)
-        {
-            rt->raw_last = raw;
-            rt->debounce_ms = 0u;
-        }
-        else
+#define KB_PENDING_AT(e, t) kb_pending_at((e), (t))
+#else
+#define KB_PENDING_AT(e, t) ((void)(e))
+#endif
+
+#if KB_USING_REPEAT_ACCEL
+/* 连发触发后计算下一次的周期：只在连发时计算，乘法 + 移位，不做除法 */
+static uint16_t kb_repeat_next_period(const keyboard_repeat_profile_t *prof, uint16_t count, uint16_t period)
+{
+    uint8_t i;
+
+    if (prof == NULL)
+    {
+        return period;
+    }
+
+    switch (prof->mode)
+    {
+    case KB_REPEAT_ACCEL_STEP:
+        for (i = 0u; i < prof->step_num; i++)
         {
-            if (rt->debounce_ms < KB_DEBOUNCE_MS)
+            if (count >= prof->steps[i].count)
             {
-                rt->debounce_ms += dt_ms;
+                period = prof->steps[i].period_ms;
             }
         }
+        break;
+    case KB_REPEAT_ACCEL_EXP:
+        /* factor_q8 已在设置时限定为 1~256，结果不会超过原周期 */
+        period = (uint16_t)(((uint32_t)period * prof->factor_q8) >> 8);
+        break;
+    default:
+        break;
+    }
 
-        if (rt->debounce_ms >= KB_DEBOUNCE_MS && rt->stable != rt->raw_last)
-        {
-            rt->stable = rt->raw_last;
-            if (rt->stable != 0u)
-            {
-                rt->press_ms = 0u;
-                rt->repeat_ms = 0u;
-                rt->long_sent = 0u;
+    return (period < prof->min_period_ms) ? prof->min_period_ms : period;
+}
+#endif
 
-                if (evt_num < (uint16_t)(KB_MAX_KEYS * 4u))
-                {
-                    pending_evt[evt_num].node = node;
-                    pending_evt[evt_num].evt = KB_EVT_PRESS;
-                    evt_num++;
-                }
-            }
-            else
-            {
-                if (evt_num < (uint16_t)(KB_MAX_KEYS * 4u))
-                {
-                    pending_evt[evt_num].node = node;
-                    pending_evt[evt_num].evt = KB_EVT_RELEASE;
-                    evt_num++;
-                }
+#if (KB_BACKEND_MODE != KB_BACKEND_CAPTURE)
+#if KB_HAS_BACKEND(KB_BACKEND_GPIO) && (!KB_USING_FIXED_BACKEND || KB_FIXED_GPIO_PORT)
+/* 按端口读取：每个端口每次 poll 只读一次 */
+static uint8_t kb_read_port_bit(kb_poll_ctx_t *pc, uint16_t index)
+{
+    const keyboard_control_t *ctl = pc->ctl;
+    uint8_t port = ctl->gpio_port[index];
 
-                if (rt->long_sent != 0u)
-                {
-                    if (evt_num < (uint16_t)(KB_MAX_KEYS * 4u))
-                    {
-                        pending_evt[evt_num].node = node;
-                        pending_evt[evt_num].evt = KB_EVT_LONGPRESS_RELEASE;
-                        evt_num++;
-                    }
-                    rt->click_count = 0u;
-                    rt->click_wait_ms = 0u;
-                }
-                else
-                {
-                    if (rt->click_count == 0u)
-                    {
-                        rt->click_count = 1u;
-                        rt->click_wait_ms = 0u;
-                    }
-                    else if (rt->click_count == 1u && rt->click_wait_ms <= KB_DOUBLE_CLICK_MS)
-                    {
-                        if (evt_num < (uint16_t)(KB_MAX_KEYS * 4u))
-                        {
-                            pending_evt[evt_num].node = node;
-                            pending_evt[evt_num].evt = KB_EVT_DOUBLE_CLICK;
-                            evt_num++;
-                        }
-                        rt->click_count = 0u;
-                        rt->click_wait_ms = 0u;
-                    }
-                    else
-                    {
-                        rt->click_count = 1u;
-                        rt->click_wait_ms = 0u;
-                    }
-                }
+    if ((pc->port_read & ((uint32_t)1u << port)) == 0u)
+    {
+        pc->port_val[port] = KB_HW_READ_PORT(ctl, port);
+        pc->port_read |= (uint32_t)1u << port;
+    }
+    return (uint8_t)((pc->port_val[port] >> ctl->gpio_bit[index]) & 1u);
+}
+#endif
 
-                rt->press_ms = 0u;
-                rt->repeat_ms = 0u;
-                rt->long_sent = 0u;
+#if KB_USING_FIXED_BACKEND
+/* 固定后端：只编译 KB_BACKEND_MODE 的采样路径。node 非空、index 在范围内由调用方保证 */
+static inline uint8_t kb_read_raw(kb_poll_ctx_t *pc, const keyboard_que_t *node, uint16_t index,
+                                  const uint8_t *snapshot)
+{
+#if (KB_BACKEND_MODE == KB_BACKEND_GPIO)
+    (void)snapshot;
+#if KB_FIXED_GPIO_PORT
+    (void)node;
+    return (uint8_t)((kb_read_port_bit(pc, index) == KB_GPIO_ACTIVE_LEVEL) ? 1u : 0u);
+#else
+#if KB_USING_BSP_INLINE
+    (void)pc;
+#endif
+    (void)index;
+    return (uint8_t)((KB_HW_READ_PIN(pc->ctl, node->hw.gpio_pin) == KB_GPIO_ACTIVE_LEVEL) ? 1u : 0u);
+#endif
+#elif (KB_BACKEND_MODE == KB_BACKEND_MATRIX)
+    uint8_t level;
+
+#if KB_USING_BSP_INLINE
+    (void)pc;
+#endif
+    (void)index;
+    (void)snapshot;
+    KB_HW_SELECT_ROW(pc->ctl, node->hw.matrix.row);
+    level = (uint8_t)KB_HW_READ_COL(pc->ctl, node->hw.matrix.col);
+    KB_HW_UNSELECT_ROW(pc->ctl, node->hw.matrix.row);
+    return (uint8_t)((level == KB_MATRIX_ACTIVE_LEVEL) ? 1u : 0u);
+#else
+    (void)pc;
+    (void)node;
+    return (uint8_t)(snapshot[index] ? 1u : 0u);
+#endif
+}
+#else
+static uint8_t kb_read_raw(kb_poll_ctx_t *pc, const keyboard_que_t *node, uint16_t index, const uint8_t *snapshot)
+{
+    const keyboard_control_t *ctl = pc->ctl;
+
+    if (node == NULL)
+    {
+        return 0u;
+    }
+
+    switch (KB_KEY_BACKEND(ctl, node))
+    {
+    case KB_BACKEND_GPIO:
+#if KB_HAS_BACKEND(KB_BACKEND_GPIO)
+        if (ctl->keyboard_ops.read_port != NULL && index < KB_MAX_KEYS)
+        {
+            return (uint8_t)((kb_read_port_bit(pc, index) == KB_GPIO_ACTIVE_LEVEL) ? 1u : 0u);
+        }
+#endif
+        if (ctl->keyboard_ops.read_pin == NULL)
+        {
+            return 0u;
+        }
+        return (uint8_t)((ctl->keyboard_ops.read_pin(node->hw.gpio_pin) == KB_GPIO_ACTIVE_LEVEL) ? 1u : 0u);
+
+    case KB_BACKEND_MATRIX:
+        if (ctl->keyboard_ops.matrix_select_row == NULL ||
+            ctl->keyboard_ops.matrix_read_col == NULL ||
+            ctl->keyboard_ops.matrix_unselect_row == NULL)
+        {
+            return 0u;
+        }
+        ctl->keyboard_ops.matrix_select_row(node->hw.matrix.row);
+        {
+            uint8_t level = (uint8_t)ctl->keyboard_ops.matrix_read_col(node->hw.matrix.col);
+            ctl->keyboard_ops.matrix_unselect_row(node->hw.matrix.row);
+            return (uint8_t)((level == KB_MATRIX_ACTIVE_LEVEL) ? 1u : 0u);
+        }
+
+    case KB_BACKEND_CUSTOM:
+    default:
+        if (snapshot == NULL || index >= KB_MAX_KEYS)
+        {
+            return 0u;
+        }
+        return (uint8_t)(snapshot[index] ? 1u : 0u);
+    }
+}
+#endif
+#endif
+
+#if KB_USING_GPIO_IRQ
+/* 脏引脚或仍在去抖（需要采样确认电平保持）的按键才读取，其余沿用上次电平 */
+static uint8_t kb_gpio_sample(kb_poll_ctx_t *pc, const keyboard_que_t *node, uint16_t index,
+                              uint8_t last, uint8_t settling)
+{
+    uint8_t pin = node->hw.gpio_pin;
+
+    if (settling == 0u && (pc->dirty[pin >> 5] & ((uint32_t)1u << (pin & 31u))) == 0u)
+    {
+        return last;
+    }
+    return kb_read_raw(pc, node, index, NULL);
+}
+#endif
+
+#if KB_USING_HYBRID
+/*
+ * 混合后端：全部按键先按组采样到 raw（按注册顺序），再交给去抖引擎。
+ * 矩阵组按注册时建好的行链表，每个用到的行只选通一次、只读该行的按键；
+ * GPIO 组走端口缓存，自定义组直接使用 scan_snapshot 的结果，两者在一次链表遍历中完成
+ */
+static void kb_sample_groups(kb_poll_ctx_t *pc, uint8_t *raw)
+{
+    keyboard_control_t *ctl = pc->ctl;
+    const keyboard_que_t *node;
+    uint16_t key_num = (ctl->key_num < KB_MAX_KEYS) ? ctl->key_num : (uint16_t)KB_MAX_KEYS;
+    uint16_t idx;
+
+    if ((ctl->backend_used & (1u << KB_BACKEND_MATRIX)) != 0u)
+    {
+        uint8_t row;
+
+        for (row = 0u; row < KB_MATRIX_MAX_ROW; row++)
+        {
+            idx = ctl->matrix_row_key[row];
+            if (idx == KB_KEY_IDX_NONE)
+            {
+                continue;
             }
+            ctl->keyboard_ops.matrix_select_row(row);
+            do
+            {
+                raw[idx] = (uint8_t)((ctl->keyboard_ops.matrix_read_col(ctl->matrix_col[idx]) ==
+                                      KB_MATRIX_ACTIVE_LEVEL) ? 1u : 0u);
+                idx = ctl->matrix_next_key[idx];
+            } while (idx != KB_KEY_IDX_NONE);
+            ctl->keyboard_ops.matrix_unselect_row(row);
         }
+    }
 
-        if (rt->stable != 0u)
+    idx = 0u;
+    for (node = ctl->head; node != NULL && idx < key_num; node = node->next)
+    {
+        if (node->backend == KB_BACKEND_GPIO)
+        {
+#if KB_USING_GPIO_IRQ
+#if KB_USING_SIMD
+            const kb_batch_state_t *st = &ctl->batch;
+
+            raw[idx] = kb_gpio_sample(pc, node, idx, st->raw_last[idx],
+                                      (uint8_t)(st->raw_last[idx] != st->stable[idx] || st->deb[idx] < KB_DEBOUNCE_MS));
+#else
+            const kb_key_runtime_t *rt = &ctl->key_rt[idx];
+
+            raw[idx] = kb_gpio_sample(pc, node, idx, rt->raw_last,
+                                      (uint8_t)(rt->raw_last != rt->stable || rt->debounce_ms < KB_DEBOUNCE_MS));
+#endif
+#else
+            raw[idx] = kb_read_raw(pc, node, idx, NULL);
+#endif
+        }
+        else if (node->backend == KB_BACKEND_CUSTOM)
         {
-            rt->press_ms += dt_ms;
+            raw[idx] = (uint8_t)(raw[idx] ? 1u : 0u);
+        }
+        idx++;
+    }
+}
+#endif
+
+
+/* 稳定电平刚发生变化（rt->stable 已更新）：按下/释放/单击/双击判定 */
+static void kb_key_on_stable(kb_poll_ctx_t *pc, kb_key_runtime_t *rt, const keyboard_que_t *node, uint16_t idx)
+{
+#if KB_USING_TIMESTAMP
+    rt->edge_set = 0u;
+#endif
+    if (rt->stable != 0u)
+    {
+#if KB_NEED_PRESS_TIMER
+        rt->press_ms = 0u;
+#endif
+#if KB_USING_REPEAT
+        rt->repeat_ms = 0u;
+        rt->repeat_count = 0u;
+#endif
+#if KB_USING_REPEAT_ACCEL
+        rt->repeat_period = KB_REPEAT_PERIOD_MS;
+#endif
+#if KB_USING_LONGPRESS
+        rt->long_sent = 0u;
+#endif
+
+        KB_PENDING_AT(kb_pending_push(pc, node, idx, KB_EVT_PRESS), rt->edge_us);
+    }
+    else
+    {
+        KB_PENDING_AT(kb_pending_push(pc, node, idx, KB_EVT_RELEASE), rt->edge_us);
 
-            if (rt->long_sent == 0u && rt->press_ms >= KB_LONGPRESS_MS)
+#if KB_USING_LONGPRESS
+        if (rt->long_sent != 0u)
+        {
+            KB_PENDING_AT(kb_pending_push(pc, node, idx, KB_EVT_LONGPRESS_RELEASE), rt->edge_us);
+#if KB_USING_DOUBLE_CLICK
+            rt->click_count = 0u;
+            rt->click_wait_ms = 0u;
+#endif
+        }
+        else
+#endif
+        {
+#if KB_USING_DOUBLE_CLICK
+            if (rt->click_count == 0u)
             {
-                rt->long_sent = 1u;
-                if (evt_num < (uint16_t)(KB_MAX_KEYS * 4u))
-                {
-                    pending_evt[evt_num].node = node;
-                    pending_evt[evt_num].evt = KB_EVT_LONGPRESS;
-                    evt_num++;
-                }
+                rt->click_count = 1u;
+                rt->click_wait_ms = 0u;
+            }
+            else if (rt->click_count == 1u && rt->click_wait_ms <= KB_DOUBLE_CLICK_MS)
+            {
+                KB_PENDING_AT(kb_pending_push(pc, node, idx, KB_EVT_DOUBLE_CLICK), rt->edge_us);
+                rt->click_count = 0u;
+                rt->click_wait_ms = 0u;
+            }
+            else
+            {
+                rt->click_count = 1u;
+                rt->click_wait_ms = 0u;
             }
+#elif KB_USING_CLICK
+            /* 不检测双击时没有等待窗口，释放即为单击 */
+            KB_PENDING_AT(kb_pending_push(pc, node, idx, KB_EVT_CLICK), rt->edge_us);
+#endif
+        }
+
+#if KB_NEED_PRESS_TIMER
+        rt->press_ms = 0u;
+#endif
+#if KB_USING_REPEAT
+        rt->repeat_ms = 0u;
+#endif
+#if KB_USING_LONGPRESS
+        rt->long_sent = 0u;
+#endif
+    }
+}
+
+#if KB_NEED_KEY_TICK
+/* 需要逐 poll 推进计时的按键：按下中（长按/连发）或等待双击 */
+static inline uint8_t kb_key_busy(const kb_key_runtime_t *rt)
+{
+    uint8_t busy = 0u;
 
-            if (rt->press_ms >= KB_REPEAT_START_MS)
+#if KB_NEED_PRESS_TIMER
+    busy |= (uint8_t)(rt->stable != 0u);
+#endif
+#if KB_USING_DOUBLE_CLICK
+    busy |= (uint8_t)(rt->stable == 0u && rt->click_count == 1u);
+#endif
+    return busy;
+}
+
+/* 计时推进：长按/连发/单击超时 */
+static void kb_key_on_tick(kb_poll_ctx_t *pc, kb_key_runtime_t *rt, const keyboard_que_t *node, uint16_t idx, uint32_t dt_ms)
+{
+#if !KB_NEED_PRESS_TIMER && !KB_USING_CLICK
+    (void)pc;
+    (void)node;
+    (void)idx;
+#endif
+    if (rt->stable != 0u)
+    {
+#if KB_NEED_PRESS_TIMER
+        rt->press_ms += dt_ms;
+#endif
+
+#if KB_USING_LONGPRESS
+        if (rt->long_sent == 0u && rt->press_ms >= KB_LONGPRESS_MS)
+        {
+            rt->long_sent = 1u;
+            KB_PENDING_AT(kb_pending_push(pc, node, idx, KB_EVT_LONGPRESS), kb_due_us(pc, rt->press_ms - KB_LONGPRESS_MS));
+        }
+#endif
+
+#if KB_USING_REPEAT
+        if (rt->press_ms >= KB_REPEAT_START_MS)
+        {
+            rt->repeat_ms += dt_ms;
+#if KB_USING_REPEAT_ACCEL
+            if (rt->repeat_ms >= rt->repeat_period)
+#else
+            if (rt->repeat_ms >= KB_REPEAT_PERIOD_MS)
+#endif
             {
-                rt->repeat_ms += dt_ms;
-                if (rt->repeat_ms >= KB_REPEAT_PERIOD_MS)
+                kb_pending_evt_t *e;
+#if KB_USING_TIMESTAMP
+#if KB_USING_REPEAT_ACCEL
+                uint32_t period = rt->repeat_period;
+#else
+                uint32_t period = KB_REPEAT_PERIOD_MS;
+#endif
+                uint32_t over = rt->repeat_ms - period;
+                uint32_t since = rt->press_ms - KB_REPEAT_START_MS;
+                uint32_t due_us;
+
+                /* 首次连发时 repeat_ms 可能含有连发开始之前的时间，到期时刻不早于“开始 + 一个周期” */
+                since = (since > period) ? (since - period) : 0u;
+                due_us = kb_due_us(pc, (over < since) ? over : since);
+#endif
+
+                rt->repeat_ms = 0u;
+                if (rt->repeat_count < 0xFFFFu)
                 {
-                    rt->repeat_ms = 0u;
-                    if (evt_num < (uint16_t)(KB_MAX_KEYS * 4u))
-                    {
-                        pending_evt[evt_num].node = node;
-                        pending_evt[evt_num].evt = KB_EVT_REPEAT;
-                        evt_num++;
-                    }
+                    rt->repeat_count++;
                 }
+#if KB_USING_REPEAT_ACCEL
+                rt->repeat_period = kb_repeat_next_period(pc->ctl->repeat_profile, rt->repeat_count, rt->repeat_period);
+#endif
+                e = kb_pending_push(pc, node, idx, KB_EVT_REPEAT);
+                if (e != NULL)
+                {
+                    e->repeat_count = rt->repeat_count;
+                }
+                KB_PENDING_AT(e, due_us);
             }
         }
-        else
+#endif
+    }
+    else
+    {
+#if KB_USING_DOUBLE_CLICK
+        if (rt->click_count == 1u)
+        {
+            rt->click_wait_ms += dt_ms;
+            if (rt->click_wait_ms >= KB_DOUBLE_CLICK_MS)
+            {
+#if KB_USING_CLICK
+                KB_PENDING_AT(kb_pending_push(pc, node, idx, KB_EVT_CLICK), kb_due_us(pc, rt->click_wait_ms - KB_DOUBLE_CLICK_MS));
+#endif
+                rt->click_count = 0u;
+                rt->click_wait_ms = 0u;
+            }
+        }
+#endif
+    }
+}
+#endif
+
+#if (KB_BACKEND_MODE == KB_BACKEND_CAPTURE)
+
+#if KB_NEED_KEY_TICK
+/* 按下中/等待双击时，计时推进到“稳定边沿至 t 时刻”的实际时长，而不是累加 dt_ms */
+static void kb_capture_advance(kb_poll_ctx_t *pc, kb_key_runtime_t *rt, const keyboard_que_t *node, uint16_t idx, uint32_t t)
+{
+    uint32_t since_ms;
+    uint32_t done_ms;
+
+    if (kb_key_busy(rt) == 0u)
+    {
+        return;
+    }
+
+    since_ms = (uint32_t)(t - rt->stable_us) / 1000u;
+#if KB_NEED_PRESS_TIMER && KB_USING_DOUBLE_CLICK
+    done_ms = (rt->stable != 0u) ? rt->press_ms : rt->click_wait_ms;
+#elif KB_NEED_PRESS_TIMER
+    done_ms = rt->press_ms;
+#else
+    done_ms = rt->click_wait_ms;
+#endif
+    if (since_ms > done_ms)
+    {
+        pc->at_us = t;
+        kb_key_on_tick(pc, rt, node, idx, since_ms - done_ms);
+        pc->at_us = pc->ctl->now_us;
+    }
+}
+#endif
+
+/* 到 t 时刻原始电平已保持 KB_DEBOUNCE_MS：确认稳定电平变化，后续计时从这次变化的边沿起算 */
+static void kb_capture_settle(kb_poll_ctx_t *pc, kb_key_runtime_t *rt, const keyboard_que_t *node, uint16_t idx, uint32_t t)
+{
+    if (rt->stable != rt->raw_last && (uint32_t)(t - rt->raw_us) >= KB_DEBOUNCE_MS * 1000u)
+    {
+#if KB_NEED_KEY_TICK
+        /* 先把长按/连发/双击窗口计时补到确认时刻，两次 poll 之间完成的松开/按下不会按上一次 poll 的计时判定 */
+        kb_capture_advance(pc, rt, node, idx, rt->raw_us + KB_DEBOUNCE_MS * 1000u);
+#endif
+        rt->stable = rt->raw_last;
+        rt->stable_us = rt->edge_us;
+        kb_key_on_stable(pc, rt, node, idx);
+    }
+}
+
+/*
+ * 输入捕获引擎：电平来自中断上报的边沿，去抖按真实边沿时刻判定（最后一次边沿之后保持 KB_DEBOUNCE_MS），
+ * 两次 poll 之间完成的短按也不会丢；按下/松开后的计时从边沿起算，精度与 poll 周期无关
+ */
+static void kb_poll_capture(kb_poll_ctx_t *pc, uint32_t dt_ms)
+{
+    keyboard_control_t *ctl = pc->ctl;
+    const keyboard_que_t *node_of[KB_MAX_KEYS];
+    const keyboard_que_t *node;
+    uint32_t now = ctl->now_us;
+    uint16_t key_num = 0u;
+    /* edge_head 以 acquire 读取：读到的下标之前的槽位已由中断写完 */
+    uint16_t head = KB_ATOMIC_LOAD_ACQ16(&ctl->edge_head);
+    uint16_t tail = ctl->edge_tail;
+    uint16_t idx;
+
+    /* 计时按边沿时刻推进，不使用 dt_ms */
+    (void)dt_ms;
+
+    for (node = ctl->head; node != NULL && key_num < KB_MAX_KEYS; node = node->next)
+    {
+        node_of[key_num++] = node;
+    }
+
+    /* 按时间顺序处理边沿；晚于本次 poll 时刻的（读 tick 之后才捕获到）留给下一次 */
+    while (tail != head)
+    {
+        const kb_edge_t *e = &ctl->edge_fifo[tail & (KB_EDGE_FIFO_LEN - 1u)];
+        uint32_t t = e->time_us;
+        uint16_t k = e->idx;
+        uint8_t level = e->level;
+
+        if ((int32_t)(t - now) > 0)
+        {
+            break;
+        }
+        tail++;
+        if (k >= key_num || level == ctl->key_rt[k].raw_last)
+        {
+            continue;
+        }
+
+        kb_capture_settle(pc, &ctl->key_rt[k], node_of[k], k, t);
+#if KB_USING_TRACE
+        if (ctl->trace != NULL)
+        {
+            keyboard_trace_on_raw(ctl->trace, k, level);
+        }
+#endif
+        kb_note_edge(&ctl->key_rt[k], level, t);
+        ctl->key_rt[k].raw_last = level;
+        ctl->key_rt[k].raw_us = t;
+    }
+    /* 槽位读完之后再以 release 归还 */
+    KB_ATOMIC_STORE_REL16(&ctl->edge_tail, tail);
+
+    /* FIFO 溢出丢了边沿：按各键最近上报的电平重新同步，时刻只能取本次 poll */
+    if (tail == head && KB_ATOMIC_XCHG32(&ctl->edge_overrun, 0u) != 0u)
+    {
+        for (idx = 0u; idx < key_num; idx++)
         {
-            if (rt->click_count == 1u)
+            kb_key_runtime_t *rt = &ctl->key_rt[idx];
+            uint8_t level = ctl->edge_level[idx];
+
+            if (level != rt->raw_last)
             {
-                rt->click_wait_ms += dt_ms;
-                if (rt->click_wait_ms >= KB_DOUBLE_CLICK_MS)
+                kb_capture_settle(pc, rt, node_of[idx], idx, now);
+#if KB_USING_TRACE
+                if (ctl->trace != NULL)
                 {
-                    if (evt_num < (uint16_t)(KB_MAX_KEYS * 4u))
-                    {
-                        pending_evt[evt_num].node = node;
-                        pending_evt[evt_num].evt = KB_EVT_CLICK;
-                        evt_num++;
-                    }
-                    rt->click_count = 0u;
-                    rt->click_wait_ms = 0u;
+                    keyboard_trace_on_raw(ctl->trace, idx, level);
                 }
+#endif
+                kb_note_edge(rt, level, now);
+                rt->raw_last = level;
+                rt->raw_us = now;
             }
         }
+    }
 
-        node = node->next;
-        idx++;
+    for (idx = 0u; idx < key_num; idx++)
+    {
+        kb_key_runtime_t *rt = &ctl->key_rt[idx];
+        uint32_t quiet_ms = (uint32_t)(now - rt->raw_us) / 1000u;
+
+        rt->debounce_ms = (quiet_ms < KB_DEBOUNCE_MS) ? quiet_ms : KB_DEBOUNCE_MS;
+        kb_capture_settle(pc, rt, node_of[idx], idx, now);
+#if KB_NEED_KEY_TICK
+        kb_capture_advance(pc, rt, node_of[idx], idx, now);
+#endif
+    }
+}
+
+#elif KB_USING_SIMD
+
+static inline uint16_t kb_ctz32(uint32_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint16_t)__builtin_ctz(v);
+#else
+    uint16_t n = 0u;
+
+    while ((v & 1u) == 0u)
+    {
+        v >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/* 批量引擎：先整体采样，再由向量内核去抖，只对需要关注的按键做事件判定 */
+static void kb_poll_batch(kb_poll_ctx_t *pc, uint8_t *raw, uint32_t dt_ms)
+{
+    keyboard_control_t *ctl = pc->ctl;
+    kb_batch_state_t *st = &ctl->batch;
+    const keyboard_que_t *node;
+    uint32_t attn[KB_SIMD_WORDS];
+    uint16_t key_num = (ctl->key_num < KB_MAX_KEYS) ? ctl->key_num : (uint16_t)KB_MAX_KEYS;
+    uint16_t idx;
+    uint16_t w;
+
+#if !KB_USING_HYBRID
+    if (KB_CTL_BACKEND(ctl) != KB_BACKEND_CUSTOM)
+    {
+        idx = 0u;
+        for (node = ctl->head; node != NULL && idx < key_num; node = node->next)
+        {
+#if KB_USING_GPIO_IRQ
+            raw[idx] = kb_gpio_sample(pc, node, idx, st->raw_last[idx],
+                                      (uint8_t)(st->raw_last[idx] != st->stable[idx] || st->deb[idx] < KB_DEBOUNCE_MS));
+#else
+            raw[idx] = kb_read_raw(pc, node, idx, NULL);
+#endif
+            idx++;
+        }
     }
+#endif
+
+    kb_simd_debounce(raw, st->raw_last, st->stable, st->deb, st->busy, attn, key_num, dt_ms);
 
-    for (idx = 0u; idx < evt_num; idx++)
+    for (w = 0u; (uint32_t)w * KB_SIMD_BLOCK < key_num; w++)
     {
-        kb_emit_event(ctl, pending_evt[idx].node, pending_evt[idx].evt);
+        uint32_t m = attn[w];
+
+        while (m != 0u)
+        {
+            kb_key_runtime_t *rt;
+
+            idx = (uint16_t)(w * KB_SIMD_BLOCK + kb_ctz32(m));
+            m &= m - 1u;
+            if (idx >= key_num)
+            {
+                break;
+            }
+            rt = &ctl->key_rt[idx];
+            node = st->node[idx];
+
+            if (rt->raw_last != st->raw_last[idx])
+            {
+#if KB_USING_TRACE
+                if (ctl->trace != NULL)
+                {
+                    keyboard_trace_on_raw(ctl->trace, idx, st->raw_last[idx]);
+                }
+#endif
+#if KB_USING_TIMESTAMP
+                kb_note_edge(rt, st->raw_last[idx], ctl->now_us);
+#endif
+                rt->raw_last = st->raw_last[idx];
+            }
+            if (rt->stable != st->stable[idx])
+            {
+                rt->stable = st->stable[idx];
+                kb_key_on_stable(pc, rt, node, idx);
+            }
+#if KB_NEED_KEY_TICK
+            kb_key_on_tick(pc, rt, node, idx, dt_ms);
+            st->busy[idx] = kb_key_busy(rt);
+#endif
+        }
     }
 }
 
+#else
+
+/* 逐键引擎：MCU 上按键少，逐键读-去抖-判定最省 RAM */
+static void kb_poll_scalar(kb_poll_ctx_t *pc, const uint8_t *snapshot, uint32_t dt_ms)
+{
+    keyboard_control_t *ctl = pc->ctl;
+    const keyboard_que_t *node = ctl->head;
+    uint16_t idx = 0u;
+
+#if KB_USING_GPIO_IRQ && !KB_USING_HYBRID
+    (void)snapshot;
+#endif
+    while (node != NULL && idx < ctl->key_num && idx < KB_MAX_KEYS)
+    {
+        kb_key_runtime_t *rt = &ctl->key_rt[idx];
+#if KB_USING_HYBRID
+        uint8_t raw = snapshot[idx];
+#elif KB_USING_GPIO_IRQ
+        uint8_t raw = kb_gpio_sample(pc, node, idx, rt->raw_last,
+                                     (uint8_t)(rt->raw_last != rt->stable || rt->debounce_ms < KB_DEBOUNCE_MS));
+#else
+        uint8_t raw = kb_read_raw(pc, node, idx, snapshot);
+#endif
+
+        if (raw != rt->raw_last)
+        {
+#if KB_USING_TRACE
+            if (ctl->trace != NULL)
+            {
+                keyboard_trace_on_raw(ctl->trace, idx, raw);
+            }
+#endif
+#if KB_USING_TIMESTAMP
+            kb_note_edge(rt, raw, ctl->now_us);
+#endif
+            rt->raw_last = raw;
+            rt->debounce_ms = 0u;
+        }
+        else
+        {
+            if (rt->debounce_ms < KB_DEBOUNCE_MS)
+            {
+                rt->debounce_ms += dt_ms;
+            }
+        }
+
+        if (rt->debounce_ms >= KB_DEBOUNCE_MS && rt->stable != rt->raw_last)
+        {
+            rt->stable = rt->raw_last;
+            kb_key_on_stable(pc, rt, node, idx);
+        }
+#if KB_NEED_KEY_TICK
+        kb_key_on_tick(pc, rt, node, idx, dt_ms);
+#endif
+
+        node = node->next;
+        idx++;
+    }
+}
+
+#endif /* KB_BACKEND_CAPTURE / KB_USING_SIMD */
+
+int keyboard_init(keyboard_control_t *ctl, const keyboard_ops_t *ops, const keyboard_cb_t *cb)
+{
+    uint16_t stride;
+    uint16_t count;
+
+    if (ctl == NULL || ops == NULL)
+    {
+        return KB_ERR_PARAM;
+    }
+
+#if KB_USING_HYBRID
+    /* 混合模式：每个按键的后端操作在注册时检查 */
+#elif KB_USING_BSP_INLINE
+    /* BSP 内联绑定：硬件访问由 keyboard_bsp.h 提供，编译期检查 */
+#elif (KB_BACKEND_MODE == KB_BACKEND_GPIO)
+#if KB_USING_FIXED_BACKEND && KB_FIXED_GPIO_PORT
+    if (ops->read_port == NULL)
+#elif KB_USING_FIXED_BACKEND
+    if (ops->read_pin == NULL)
+#else
+    if (ops->read_pin == NULL && ops->read_port == NULL)
+#endif
+    {
+        return KB_ERR_BACKEND;
+    }
+#elif (KB_BACKEND_MODE == KB_BACKEND_MATRIX)
+    if (ops->matrix_select_row == NULL || ops->matrix_read_col == NULL || ops->matrix_unselect_row == NULL)
+    {
+        return KB_ERR_BACKEND;
+    }
+#elif (KB_BACKEND_MODE == KB_BACKEND_CUSTOM) && KB_USING_FIXED_BACKEND
+    if (ops->scan_snapshot == NULL)
+    {
+        return KB_ERR_BACKEND;
+    }
+#elif (KB_BACKEND_MODE == KB_BACKEND_CAPTURE)
+    /* 边沿时刻和 poll 时刻必须是同一个微秒时钟 */
+    if (ops->get_tick_us == NULL)
+    {
+        return KB_ERR_BACKEND;
+    }
+#endif
+
+    stride = MPOOL_ALIGN_UP((uint16_t)(sizeof(keyboard_que_t) + sizeof(mpool_node_t)));
+    count = (uint16_t)(KEYBOARD_POOL_SIZE / stride);
+
+    if (count == 0u)
+    {
+        return KB_ERR_POOL_CFG;
+    }
+    if (count > KB_MAX_KEYS)
+    {
+        count = KB_MAX_KEYS;
+    }
+
+    mpool_init(&ctl->key_pool, ctl->key_pool_buf, (uint16_t)sizeof(keyboard_que_t), count);
+
+    ctl->backend_mode = (uint8_t)KB_BACKEND_MODE;
+    ctl->keyboard_ops = *ops;
+    ctl->keyboard_cb.on_event = (cb != NULL) ? cb->on_event : NULL;
+    ctl->keyboard_cb.user = (cb != NULL) ? cb->user : NULL;
+#if KB_USING_DEFERRED_DISPATCH
+    ctl->keyboard_cb.on_overrun = (cb != NULL) ? cb->on_overrun : NULL;
+#endif
+    ctl->head = NULL;
+    ctl->key_num = 0;
+    ctl->keyboard_pool = &ctl->key_pool;
+    ctl->evt_dropped = 0u;
+#if KB_USING_TRACE
+    ctl->trace = NULL;
+    ctl->polled = 0u;
+#endif
+#if KB_USING_EVENT_QUEUE
+    ctl->evt_head = 0u;
+    ctl->evt_tail = 0u;
+    ctl->evt_queue_dropped = 0u;
+#if !KB_USING_DEFERRED_DISPATCH
+    ctl->evt_waiter = 0u;
+#endif
+#endif
+#if KB_USING_SUBSCRIBER
+    memset(ctl->sub_tab, 0, sizeof(ctl->sub_tab));
+    ctl->sub_gen = 0u;
+#endif
+#if KB_USING_DEFERRED_DISPATCH
+    ctl->cb_budget_us = KB_DISPATCH_BUDGET_US;
+    ctl->cb_max_us = 0u;
+    ctl->cb_overrun = 0u;
+    memset(&ctl->cb_overrun_evt, 0, sizeof(ctl->cb_overrun_evt));
+#endif
+    memset(ctl->key_rt, 0, sizeof(ctl->key_rt));
+#if KB_USING_REPEAT_ACCEL
+    ctl->repeat_profile = NULL;
+#endif
+#if KB_USING_TIMESTAMP
+    ctl->now_us = 0u;
+#endif
+#if KB_USING_HYBRID
+    ctl->backend_used = 0u;
+    memset(ctl->matrix_row_key, 0xFF, sizeof(ctl->matrix_row_key));
+#endif
+#if KB_USING_GPIO_IRQ
+    /* 初始电平未知，第一次 poll 读取全部引脚 */
+    memset(ctl->gpio_dirty, 0xFF, sizeof(ctl->gpio_dirty));
+#endif
+#if (KB_BACKEND_MODE == KB_BACKEND_CAPTURE)
+    ctl->edge_head = 0u;
+    ctl->edge_tail = 0u;
+    memset((void *)ctl->edge_level, 0, sizeof(ctl->edge_level));
+    ctl->edge_overrun = 0u;
+    ctl->edge_dropped = 0u;
+#endif
+#if KB_USING_SIMD
+    memset(&ctl->batch, 0, sizeof(ctl->batch));
+#endif
+
+    return KB_OK;
+}
+
+int keyboard_register_key(const keyboard_key_cfg_t *cfg, keyboard_control_t *ctl)
+{
+    keyboard_que_t *node;
+    keyboard_que_t *tail;
+    uint8_t backend;
+
+    if (ctl == NULL || cfg == NULL || cfg->keyname == NULL || ctl->keyboard_pool == NULL)
+    {
+        return KB_ERR_PARAM;
+    }
+
+#if KB_USING_HYBRID
+    /* 后端必须显式填写：0 或其他未知值多半是未初始化的 cfg，不当作默认后端 */
+    backend = cfg->backend;
+    if (backend != KB_BACKEND_GPIO && backend != KB_BACKEND_MATRIX && backend != KB_BACKEND_CUSTOM)
+    {
+        return KB_ERR_PARAM;
+    }
+    if (kb_backend_ready(&ctl->keyboard_ops, backend) == 0u)
+    {
+        return KB_ERR_BACKEND;
+    }
+#else
+    backend = ctl->backend_mode;
+#endif
+
+    if (backend == KB_BACKEND_MATRIX)
+    {
+        if (cfg->hw.matrix.row >= KB_MATRIX_MAX_ROW || cfg->hw.matrix.col >= KB_MATRIX_MAX_COL)
+        {
+            return KB_ERR_RANGE;
+        }
+    }
+#if KB_HAS_BACKEND(KB_BACKEND_GPIO)
+    if (backend == KB_BACKEND_GPIO &&
+        (KB_GPIO_PORT_OF(cfg->hw.gpio_pin) >= KB_GPIO_MAX_PORTS || KB_GPIO_BIT_OF(cfg->hw.gpio_pin) >= 32u))
+    {
+        return KB_ERR_RANGE;
+    }
+#endif
+
+    if (ctl->keyboard_ops.lock != NULL)
+    {
+        ctl->keyboard_ops.lock();
+    }
+
+    tail = ctl->head;
+    while (tail != NULL)
+    {
+        if (tail->key_id == cfg->key_id ||
+            (KB_KEY_BACKEND(ctl, tail) == backend && kb_hw_equal(backend, &tail->hw, &cfg->hw)))
+        {
+            if (ctl->keyboard_ops.unlock != NULL)
+            {
+                ctl->keyboard_ops.unlock();
+            }
+            return KB_ERR_DUPLICATE;
+        }
+        if (tail->next == NULL)
+        {
+            break;
+        }
+        tail = tail->next;
+    }
+
+    if (ctl->key_num >= KB_MAX_KEYS)
+    {
+        if (ctl->keyboard_ops.unlock != NULL)
+        {
+            ctl->keyboard_ops.unlock();
+        }
+        return KB_ERR_FULL;
+    }
+
+    node = (keyboard_que_t *)mpool_alloc(ctl->keyboard_pool);
+    if (node == NULL)
+    {
+        if (ctl->keyboard_ops.unlock != NULL)
+        {
+            ctl->keyboard_ops.unlock();
+        }
+        return KB_ERR_NOMEM;
+    }
+
+    node->keyname = cfg->keyname;
+    node->key_id = cfg->key_id;
+    node->hw = cfg->hw;
+#if KB_USING_HYBRID
+    node->backend = backend;
+    ctl->backend_used |= (uint8_t)(1u << backend);
+    if (backend == KB_BACKEND_MATRIX)
+    {
+        /* 插到该行链表头部：同一行内的读取顺序不影响结果 */
+        ctl->matrix_col[ctl->key_num] = cfg->hw.matrix.col;
+        ctl->matrix_next_key[ctl->key_num] = ctl->matrix_row_key[cfg->hw.matrix.row];
+        ctl->matrix_row_key[cfg->hw.matrix.row] = ctl->key_num;
+    }
+#endif
+    node->next = NULL;
+
+#if KB_USING_SIMD
+    ctl->batch.node[ctl->key_num] = node;
+#endif
+#if KB_HAS_BACKEND(KB_BACKEND_GPIO)
+    if (backend == KB_BACKEND_GPIO)
+    {
+        ctl->gpio_port[ctl->key_num] = KB_GPIO_PORT_OF(cfg->hw.gpio_pin);
+        ctl->gpio_bit[ctl->key_num] = KB_GPIO_BIT_OF(cfg->hw.gpio_pin);
+    }
+#endif
+
+    if (tail == NULL)
+    {
+        ctl->head = node;
+    }
+    else
+    {
+        tail->next = node;
+    }
+    ctl->key_num++;
+
+    if (ctl->keyboard_ops.unlock != NULL)
+    {
+        ctl->keyboard_ops.unlock();
+    }
+    return KB_OK;
+}
+
+int keyboard_register_gpio(uint8_t pin, const char *key_name, uint16_t key_id, keyboard_control_t *ctl)
+{
+    keyboard_key_cfg_t cfg;
+
+    cfg.keyname = key_name;
+    cfg.key_id = key_id;
+    cfg.hw.gpio_pin = pin;
+#if KB_USING_HYBRID
+    cfg.backend = KB_BACKEND_GPIO;
+#endif
+
+    return keyboard_register_key(&cfg, ctl);
+}
+
+int keyboard_register_matrix(uint8_t row, uint8_t col, const char *key_name, uint16_t key_id, keyboard_control_t *ctl)
+{
+    keyboard_key_cfg_t cfg;
+
+    cfg.keyname = key_name;
+    cfg.key_id = key_id;
+    cfg.hw.matrix.row = row;
+    cfg.hw.matrix.col = col;
+#if KB_USING_HYBRID
+    cfg.backend = KB_BACKEND_MATRIX;
+#endif
+
+    return keyboard_register_key(&cfg, ctl);
+}
+
+void keyboard_poll(keyboard_control_t *ctl, uint32_t dt_ms)
+{
+#if (KB_BACKEND_MODE != KB_BACKEND_CAPTURE)
+    uint8_t custom_snapshot[KB_RAW_BUF_LEN] = {0};
+#endif
+    kb_poll_ctx_t pc;
+    uint16_t idx;
+
+    if (ctl == NULL || dt_ms == 0u)
+    {
+        return;
+    }
+
+#if KB_USING_FIXED_BACKEND
+#if (KB_BACKEND_MODE == KB_BACKEND_CUSTOM)
+    if (KB_HW_SCAN_SNAPSHOT(ctl, custom_snapshot, ctl->key_num) != 0)
+    {
+        return;
+    }
+#endif
+#elif (KB_BACKEND_MODE != KB_BACKEND_CAPTURE)
+#if KB_USING_HYBRID
+    if ((ctl->backend_used & (1u << KB_BACKEND_CUSTOM)) != 0u)
+#else
+    if (ctl->backend_mode == KB_BACKEND_CUSTOM)
+#endif
+    {
+        if (ctl->keyboard_ops.scan_snapshot == NULL)
+        {
+            return;
+        }
+        if (ctl->keyboard_ops.scan_snapshot(custom_snapshot, ctl->key_num) != 0)
+        {
+            return;
+        }
+    }
+#endif
+
+#if KB_USING_TRACE
+    if (ctl->trace != NULL)
+    {
+        keyboard_trace_on_poll(ctl->trace, dt_ms);
+    }
+    ctl->polled = 1u;
+#endif
+#if KB_USING_TIMESTAMP
+    if (ctl->keyboard_ops.get_tick_us != NULL)
+    {
+        ctl->now_us = ctl->keyboard_ops.get_tick_us();
+    }
+    else if (ctl->keyboard_ops.get_tick_ms != NULL)
+    {
+        /* 毫秒 tick 回绕时乘 1000 后的结果仍然连续 */
+        ctl->now_us = ctl->keyboard_ops.get_tick_ms() * 1000u;
+    }
+    else
+    {
+        ctl->now_us += dt_ms * 1000u;
+    }
+#endif
+
+    pc.ctl = ctl;
+    pc.evt_num = 0u;
+    pc.evt = ctl->pending_evt;
+#if KB_USING_TIMESTAMP
+    pc.at_us = ctl->now_us;
+#endif
+#if KB_HAS_BACKEND(KB_BACKEND_GPIO)
+    pc.port_read = 0u;
+#endif
+#if KB_USING_GPIO_IRQ
+    /* 先取走脏位再读引脚：读之后到来的中断会留到下一次 poll */
+    for (idx = 0u; idx < KB_GPIO_DIRTY_WORDS; idx++)
+    {
+        pc.dirty[idx] = KB_ATOMIC_XCHG32(&ctl->gpio_dirty[idx], 0u);
+    }
+#endif
+
+#if KB_USING_HYBRID
+    kb_sample_groups(&pc, custom_snapshot);
+#endif
+
+#if (KB_BACKEND_MODE == KB_BACKEND_CAPTURE)
+    kb_poll_capture(&pc, dt_ms);
+#elif KB_USING_SIMD
+    kb_poll_batch(&pc, custom_snapshot, dt_ms);
+#else
+    kb_poll_scalar(&pc, custom_snapshot, dt_ms);
+#endif
+#if KB_USING_TIMESTAMP
+    kb_pending_sort(&pc);
+#endif
+
+    for (idx = 0u; idx < pc.evt_num; idx++)
+    {
+#if KB_USING_TRACE
+        if (ctl->trace != NULL)
+        {
+            keyboard_trace_on_event(ctl->trace, pc.evt[idx].idx, pc.evt[idx].evt);
+        }
+#endif
+        kb_emit_event(ctl, &pc.evt[idx]);
+    }
+
+#if KB_USING_EVENT_QUEUE
+    /* 每次 poll 最多通知一次，等待方醒来后会把队列取空 */
+#if KB_USING_DEFERRED_DISPATCH
+    if (pc.evt_num != 0u && ctl->keyboard_ops.evt_post != NULL)
+#else
+    if (pc.evt_num != 0u && ctl->keyboard_ops.evt_post != NULL && KB_ATOMIC_LOAD_ACQ16(&ctl->evt_waiter) != 0u)
+#endif
+    {
+        ctl->keyboard_ops.evt_post(ctl->keyboard_ops.evt_sem);
+    }
+#endif
+}
+
+#if KB_USING_GPIO_IRQ
+void keyboard_gpio_irq(keyboard_control_t *ctl, uint8_t pin)
+{
+    if (ctl == NULL)
+    {
+        return;
+    }
+
+    KB_ATOMIC_OR32(&ctl->gpio_dirty[pin >> 5], (uint32_t)1u << (pin & 31u));
+    if (ctl->keyboard_ops.wakeup != NULL)
+    {
+        ctl->keyboard_ops.wakeup();
+    }
+}
+
+uint8_t keyboard_is_idle(const keyboard_control_t *ctl)
+{
+    uint16_t idx;
+
+    if (ctl == NULL)
+    {
+        return 1u;
+    }
+
+#if KB_USING_HYBRID
+    /* 矩阵/自定义按键不会触发 keyboard_gpio_irq()，混合模式下有这类按键时必须保持周期 poll */
+    if ((ctl->backend_used & (uint8_t)~(1u << KB_BACKEND_GPIO)) != 0u)
+    {
+        return 0u;
+    }
+#endif
+    for (idx = 0u; idx < KB_GPIO_DIRTY_WORDS; idx++)
+    {
+        if (KB_ATOMIC_LOAD32(&ctl->gpio_dirty[idx]) != 0u)
+        {
+            return 0u;
+        }
+    }
+    for (idx = 0u; idx < ctl->key_num && idx < KB_MAX_KEYS; idx++)
+    {
+        const kb_key_runtime_t *rt = &ctl->key_rt[idx];
+
+#if KB_USING_DOUBLE_CLICK
+        if (rt->stable != 0u || rt->raw_last != 0u || rt->click_count != 0u)
+#else
+        if (rt->stable != 0u || rt->raw_last != 0u)
+#endif
+        {
+            return 0u;
+        }
+    }
+    return 1u;
+}
+#endif
+
+#if (KB_BACKEND_MODE == KB_BACKEND_CAPTURE)
+int keyboard_capture_edge(keyboard_control_t *ctl, uint16_t idx, uint8_t level, uint32_t time_us)
+{
+    kb_edge_t *e;
+    uint16_t head;
+
+    if (ctl == NULL || idx >= KB_MAX_KEYS)
+    {
+        return KB_ERR_PARAM;
+    }
+
+    level = (uint8_t)(level ? 1u : 0u);
+    ctl->edge_level[idx] = level;
+
+    head = ctl->edge_head;
+    /* edge_tail 以 acquire 读取：poll 取走槽位内容之后才会被覆盖 */
+    if ((uint16_t)(head - KB_ATOMIC_LOAD_ACQ16(&ctl->edge_tail)) >= KB_EDGE_FIFO_LEN)
+    {
+        ctl->edge_dropped++;
+        /* release：poll 取走溢出标志时能看到上面写入的 edge_level */
+        KB_ATOMIC_OR32(&ctl->edge_overrun, 1u);
+        return KB_ERR_FULL;
+    }
+
+    e = &ctl->edge_fifo[head & (KB_EDGE_FIFO_LEN - 1u)];
+    e->time_us = time_us;
+    e->idx = idx;
+    e->level = level;
+    /* 槽位写完之后再以 release 发布 head，poll 以 acquire 读到新的 head 时一定能看到完整的槽位 */
+    KB_ATOMIC_STORE_REL16(&ctl->edge_head, (uint16_t)(head + 1u));
+
+    return KB_OK;
+}
+#endif
+
+#if KB_USING_EVENT_QUEUE
+/* 出队；lock/unlock 只用于多个消费者任务之间（以及开启连发合并时与 poll 之间） */
+static uint8_t kb_evt_dequeue(keyboard_control_t *ctl, keyboard_event_t *evt)
+{
+    uint16_t head;
+    uint8_t ok = 0u;
+
+    if (ctl->keyboard_ops.lock != NULL)
+    {
+        ctl->keyboard_ops.lock();
+    }
+    head = ctl->evt_head;
+    if (head != KB_ATOMIC_LOAD_ACQ16(&ctl->evt_tail))
+    {
+        *evt = ctl->evt_queue[head & (KB_EVENT_QUEUE_LEN - 1u)];
+        KB_ATOMIC_STORE_REL16(&ctl->evt_head, (uint16_t)(head + 1u));
+        ok = 1u;
+    }
+    if (ctl->keyboard_ops.unlock != NULL)
+    {
+        ctl->keyboard_ops.unlock();
+    }
+    return ok;
+}
+
+int keyboard_wait_event(keyboard_control_t *ctl, keyboard_event_t *evt, uint32_t timeout_ms)
+{
+    uint32_t start = 0u;
+    uint32_t remain = timeout_ms;
+
+    if (ctl == NULL || evt == NULL)
+    {
+        return KB_ERR_PARAM;
+    }
+#if !KB_USING_DEFERRED_DISPATCH
+    /* 第一次调用起 poll 才把事件写入队列 */
+    KB_ATOMIC_STORE_REL16(&ctl->evt_waiter, 1u);
+#endif
+    if (ctl->keyboard_ops.get_tick_ms != NULL)
+    {
+        start = ctl->keyboard_ops.get_tick_ms();
+    }
+
+    /*
+     * 通知按 poll 发出而不是按事件，计数型信号量可能留有多余的计数，
+     * 醒来后队列为空时继续等待剩余时间；没有 get_tick_ms 算不出剩余时间，有限超时直接返回超时
+     */
+    for (;;)
+    {
+        if (kb_evt_dequeue(ctl, evt))
+        {
+            return KB_OK;
+        }
+        if (remain == 0u)
+        {
+            return KB_ERR_TIMEOUT;
+        }
+        if (ctl->keyboard_ops.evt_wait == NULL)
+        {
+            return KB_ERR_BACKEND;
+        }
+        if (ctl->keyboard_ops.evt_wait(ctl->keyboard_ops.evt_sem, remain) != 0)
+        {
+            return kb_evt_dequeue(ctl, evt) ? KB_OK : KB_ERR_TIMEOUT;
+        }
+        if (timeout_ms != KB_WAIT_FOREVER)
+        {
+            uint32_t elapsed = timeout_ms;
+
+            if (ctl->keyboard_ops.get_tick_ms != NULL)
+            {
+                elapsed = ctl->keyboard_ops.get_tick_ms() - start;
+            }
+            remain = (elapsed >= timeout_ms) ? 0u : (timeout_ms - elapsed);
+        }
+    }
+}
+#endif
+
+#if KB_USING_DEFERRED_DISPATCH
+uint16_t keyboard_dispatch(keyboard_control_t *ctl)
+{
+    keyboard_event_t evt;
+    uint16_t n = 0u;
+
+    if (ctl == NULL)
+    {
+        return 0u;
+    }
+
+    /* 每次最多处理一个队列长度的事件，poll 持续产生事件时也不会一直占住任务 */
+    while (n < KB_EVENT_QUEUE_LEN && kb_evt_dequeue(ctl, &evt))
+    {
+        kb_deliver(ctl, &evt);
+        n++;
+    }
+
+    return n;
+}
+#endif
+
+#if KB_USING_REPEAT_ACCEL
+int keyboard_set_repeat_profile(keyboard_control_t *ctl, const keyboard_repeat_profile_t *profile)
+{
+    if (ctl == NULL)
+    {
+        return KB_ERR_PARAM;
+    }
+    if (profile != NULL)
+    {
+        if (profile->min_period_ms == 0u ||
+            (profile->mode == KB_REPEAT_ACCEL_STEP && profile->step_num != 0u && profile->steps == NULL) ||
+            (profile->mode == KB_REPEAT_ACCEL_EXP && (profile->factor_q8 == 0u || profile->factor_q8 > 256u)) ||
+            (profile->mode != KB_REPEAT_ACCEL_STEP && profile->mode != KB_REPEAT_ACCEL_EXP))
+        {
+            return KB_ERR_PARAM;
+        }
+    }
+
+    ctl->repeat_profile = profile;
+    return KB_OK;
+}
+#endif
+
+#if KB_USING_KEY_HANDLER
+int keyboard_set_key_handler(keyboard_control_t *ctl, uint16_t key_id, const keyboard_key_handler_t *handler)
+{
+    const keyboard_que_t *node;
+    uint16_t idx = 0u;
+
+    if (ctl == NULL || (handler != NULL && handler->on_event == NULL))
+    {
+        return KB_ERR_PARAM;
+    }
+
+    for (node = ctl->head; node != NULL; node = node->next)
+    {
+        if (node->key_id == key_id)
+        {
+            break;
+        }
+        idx++;
+    }
+    if (node == NULL || idx >= KB_MAX_KEYS)
+    {
+        return KB_ERR_PARAM;
+    }
+
+    /* 单个指针的 release 写入：分发方要么看到旧的一对，要么看到新的一对 */
+    KB_ATOMIC_STORE_REL_PTR(&ctl->key_rt[idx].handler, handler);
+
+    return KB_OK;
+}
+#endif
+
+#if KB_USING_SUBSCRIBER
+/* 取出当前版本的副本用于修改，调用者持锁 */
+static kb_sub_table_t *kb_sub_edit_begin(keyboard_control_t *ctl)
+{
+    uint16_t gen = KB_ATOMIC_LOAD_ACQ16(&ctl->sub_gen);
+    kb_sub_table_t *next = &ctl->sub_tab[(gen + 1u) & 1u];
+
+    /* 上一版本号的发布先于对这份表的改写，读者据此发现表被改写 */
+    KB_ATOMIC_FENCE_REL();
+    *next = ctl->sub_tab[gen & 1u];
+    return next;
+}
+
+/* 重建按事件类型划分的订阅者列表并发布为当前版本，调用者持锁 */
+static void kb_sub_edit_commit(keyboard_control_t *ctl, kb_sub_table_t *tab)
+{
+    uint8_t e;
+    uint8_t i;
+
+    for (e = 0u; e < KB_EVT_NUM; e++)
+    {
+        tab->num[e] = 0u;
+        for (i = 0u; i < KB_MAX_SUBSCRIBERS; i++)
+        {
+            if (tab->sub[i].on_event != NULL && (tab->sub[i].evt_mask & KB_EVT_MASK(e)) != 0u)
+            {
+                tab->list[e][tab->num[e]++] = i;
+            }
+        }
+    }
+    KB_ATOMIC_STORE_REL16(&ctl->sub_gen, (uint16_t)(KB_ATOMIC_LOAD_ACQ16(&ctl->sub_gen) + 1u));
+}
+
+int keyboard_subscribe(keyboard_control_t *ctl, const keyboard_subscriber_t *sub)
+{
+    kb_sub_table_t *tab;
+    int handle = KB_ERR_FULL;
+    uint8_t i;
+
+    if (ctl == NULL || sub == NULL || sub->on_event == NULL || sub->key_min > sub->key_max)
+    {
+        return KB_ERR_PARAM;
+    }
+
+    if (ctl->keyboard_ops.lock != NULL)
+    {
+        ctl->keyboard_ops.lock();
+    }
+    tab = kb_sub_edit_begin(ctl);
+    for (i = 0u; i < KB_MAX_SUBSCRIBERS; i++)
+    {
+        if (tab->sub[i].on_event == NULL)
+        {
+            tab->sub[i] = *sub;
+            kb_sub_edit_commit(ctl, tab);
+            handle = (int)i;
+            break;
+        }
+    }
+    if (ctl->keyboard_ops.unlock != NULL)
+    {
+        ctl->keyboard_ops.unlock();
+    }
+
+    return handle;
+}
+
+int keyboard_unsubscribe(keyboard_control_t *ctl, int handle)
+{
+    kb_sub_table_t *tab;
+
+    if (ctl == NULL || handle < 0 || handle >= (int)KB_MAX_SUBSCRIBERS)
+    {
+        return KB_ERR_PARAM;
+    }
+
+    if (ctl->keyboard_ops.lock != NULL)
+    {
+        ctl->keyboard_ops.lock();
+    }
+    tab = kb_sub_edit_begin(ctl);
+    tab->sub[handle].on_event = NULL;
+    kb_sub_edit_commit(ctl, tab);
+    if (ctl->keyboard_ops.unlock != NULL)
+    {
+        ctl->keyboard_ops.unlock();
+    }
+
+    return KB_OK;
+}
+#endif
+
+int keyboard_get_key_state(const keyboard_control_t *ctl, uint16_t idx, keyboard_key_state_t *state)
+{
+    const kb_key_runtime_t *rt;
+
+    if (ctl == NULL || state == NULL)
+    {
+        return KB_ERR_PARAM;
+    }
+    if (idx >= ctl->key_num || idx >= KB_MAX_KEYS)
+    {
+        return KB_ERR_RANGE;
+    }
+
+    rt = &ctl->key_rt[idx];
+    state->raw = rt->raw_last;
+    state->stable = rt->stable;
+#if KB_USING_SIMD
+    state->debounce_ms = ctl->batch.deb[idx];
+#else
+    state->debounce_ms = rt->debounce_ms;
+#endif
+    state->long_sent = 0u;
+    state->click_count = 0u;
+    state->press_ms = 0u;
+    state->repeat_ms = 0u;
+    state->click_wait_ms = 0u;
+#if KB_USING_LONGPRESS
+    state->long_sent = rt->long_sent;
+#endif
+#if KB_USING_DOUBLE_CLICK
+    state->click_count = rt->click_count;
+    state->click_wait_ms = rt->click_wait_ms;
+#endif
+#if KB_NEED_PRESS_TIMER
+    state->press_ms = rt->press_ms;
+#endif
+#if KB_USING_REPEAT
+    state->repeat_ms = rt->repeat_ms;
+#endif
+
+    return KB_OK;
+}
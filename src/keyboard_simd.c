@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+
+#include "keyboard_simd.h"
+
+#if KB_USING_SIMD
+
+#if defined(KB_SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(KB_SIMD_SSE2)
+#include <emmintrin.h>
+#elif defined(KB_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+/*
+ * 每个按键的处理与 keyboard_poll() 逐键实现等价：
+ *   chg    = raw != raw_last
+ *   deb    = chg ? 0 : min(deb + dt, DEBOUNCE)
+ *   edge   = deb >= DEBOUNCE && stable != raw
+ *   stable = edge ? raw : stable
+ * 去抖计时一旦达到阈值就只参与 >= 比较，饱和在阈值处不影响结果。
+ */
+
+#if defined(KB_SIMD_SSE2) || defined(KB_SIMD_AVX2)
+
+/* SSE2 没有无符号 16 位 min：min(a, b) = a - sat(a - b) */
+static inline __m128i kb_sse2_debounce16(__m128i deb, __m128i chg16, __m128i dt16, __m128i lim)
+{
+    __m128i x = _mm_adds_epu16(deb, dt16);
+
+    x = _mm_sub_epi16(x, _mm_subs_epu16(x, lim));
+    return _mm_andnot_si128(chg16, x);
+}
+
+static inline uint32_t kb_sse2_block16(const uint8_t *raw, uint8_t *raw_last, uint8_t *stable,
+                                       uint16_t *deb, const uint8_t *busy, __m128i dt16, __m128i lim)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i r = _mm_loadu_si128((const __m128i *)raw);
+    __m128i last = _mm_loadu_si128((const __m128i *)raw_last);
+    __m128i st = _mm_loadu_si128((const __m128i *)stable);
+    __m128i b = _mm_loadu_si128((const __m128i *)busy);
+    __m128i d0 = _mm_loadu_si128((const __m128i *)deb);
+    __m128i d1 = _mm_loadu_si128((const __m128i *)(deb + 8));
+    __m128i chg;
+    __m128i ready;
+    __m128i edge;
+    __m128i attn;
+
+    r = _mm_andnot_si128(_mm_cmpeq_epi8(r, zero), one);
+    chg = _mm_xor_si128(_mm_cmpeq_epi8(r, last), _mm_set1_epi8(-1));
+    _mm_storeu_si128((__m128i *)raw_last, r);
+
+    d0 = kb_sse2_debounce16(d0, _mm_unpacklo_epi8(chg, chg), dt16, lim);
+    d1 = kb_sse2_debounce16(d1, _mm_unpackhi_epi8(chg, chg), dt16, lim);
+    _mm_storeu_si128((__m128i *)deb, d0);
+    _mm_storeu_si128((__m128i *)(deb + 8), d1);
+
+    ready = _mm_packs_epi16(_mm_cmpeq_epi16(_mm_subs_epu16(lim, d0), zero),
+                            _mm_cmpeq_epi16(_mm_subs_epu16(lim, d1), zero));
+    edge = _mm_andnot_si128(_mm_cmpeq_epi8(st, r), ready);
+    st = _mm_or_si128(_mm_and_si128(edge, r), _mm_andnot_si128(edge, st));
+    _mm_storeu_si128((__m128i *)stable, st);
+
+    attn = _mm_or_si128(_mm_or_si128(chg, edge), _mm_xor_si128(_mm_cmpeq_epi8(b, zero), _mm_set1_epi8(-1)));
+    return (uint32_t)_mm_movemask_epi8(attn);
+}
+
+#endif /* KB_SIMD_SSE2 || KB_SIMD_AVX2 */
+
+#if defined(KB_SIMD_AVX2)
+
+static uint32_t kb_simd_block(const uint8_t *raw, uint8_t *raw_last, uint8_t *stable,
+                              uint16_t *deb, const uint8_t *busy, uint16_t dt16, uint16_t lim16)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi8(-1);
+    const __m256i dtv = _mm256_set1_epi16((short)dt16);
+    const __m256i lim = _mm256_set1_epi16((short)lim16);
+    __m256i r = _mm256_loadu_si256((const __m256i *)raw);
+    __m256i last = _mm256_loadu_si256((const __m256i *)raw_last);
+    __m256i st = _mm256_loadu_si256((const __m256i *)stable);
+    __m256i b = _mm256_loadu_si256((const __m256i *)busy);
+    __m256i d0 = _mm256_loadu_si256((const __m256i *)deb);
+    __m256i d1 = _mm256_loadu_si256((const __m256i *)(deb + 16));
+    __m256i chg;
+    __m256i c0;
+    __m256i c1;
+    __m256i ready;
+    __m256i edge;
+    __m256i attn;
+
+    r = _mm256_andnot_si256(_mm256_cmpeq_epi8(r, zero), _mm256_set1_epi8(1));
+    chg = _mm256_xor_si256(_mm256_cmpeq_epi8(r, last), ones);
+    _mm256_storeu_si256((__m256i *)raw_last, r);
+
+    /* 按内存顺序扩展到 16 位：前 16 个键 / 后 16 个键 */
+    c0 = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(chg));
+    c1 = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(chg, 1));
+    d0 = _mm256_andnot_si256(c0, _mm256_min_epu16(_mm256_adds_epu16(d0, dtv), lim));
+    d1 = _mm256_andnot_si256(c1, _mm256_min_epu16(_mm256_adds_epu16(d1, dtv), lim));
+    _mm256_storeu_si256((__m256i *)deb, d0);
+    _mm256_storeu_si256((__m256i *)(deb + 16), d1);
+
+    /* packs 在 128 位通道内交错，重排回键序 */
+    ready = _mm256_packs_epi16(_mm256_cmpeq_epi16(_mm256_max_epu16(d0, lim), d0),
+                               _mm256_cmpeq_epi16(_mm256_max_epu16(d1, lim), d1));
+    ready = _mm256_permute4x64_epi64(ready, 0xD8);
+    edge = _mm256_andnot_si256(_mm256_cmpeq_epi8(st, r), ready);
+    st = _mm256_blendv_epi8(st, r, edge);
+    _mm256_storeu_si256((__m256i *)stable, st);
+
+    attn = _mm256_or_si256(_mm256_or_si256(chg, edge), _mm256_xor_si256(_mm256_cmpeq_epi8(b, zero), ones));
+    return (uint32_t)_mm256_movemask_epi8(attn);
+}
+
+#elif defined(KB_SIMD_SSE2)
+
+static uint32_t kb_simd_block(const uint8_t *raw, uint8_t *raw_last, uint8_t *stable,
+                              uint16_t *deb, const uint8_t *busy, uint16_t dt16, uint16_t lim16)
+{
+    const __m128i dtv = _mm_set1_epi16((short)dt16);
+    const __m128i lim = _mm_set1_epi16((short)lim16);
+    uint32_t lo = kb_sse2_block16(raw, raw_last, stable, deb, busy, dtv, lim);
+    uint32_t hi = kb_sse2_block16(raw + 16, raw_last + 16, stable + 16, deb + 16, busy + 16, dtv, lim);
+
+    return lo | (hi << 16);
+}
+
+#elif defined(KB_SIMD_NEON)
+
+static inline uint32_t kb_neon_block16(const uint8_t *raw, uint8_t *raw_last, uint8_t *stable,
+                                       uint16_t *deb, const uint8_t *busy, uint16x8_t dtv, uint16x8_t lim)
+{
+    static const uint8_t bit_weight[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t r = vld1q_u8(raw);
+    uint8x16_t last = vld1q_u8(raw_last);
+    uint8x16_t st = vld1q_u8(stable);
+    uint8x16_t b = vld1q_u8(busy);
+    uint16x8_t d0 = vld1q_u16(deb);
+    uint16x8_t d1 = vld1q_u16(deb + 8);
+    uint16x8_t c0;
+    uint16x8_t c1;
+    uint8x16_t chg;
+    uint8x16_t ready;
+    uint8x16_t edge;
+    uint8x16_t attn;
+    uint64x2_t sum;
+
+    r = vandq_u8(vtstq_u8(r, r), vdupq_n_u8(1));
+    chg = vmvnq_u8(vceqq_u8(r, last));
+    vst1q_u8(raw_last, r);
+
+    c0 = vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(vget_low_u8(chg))));
+    c1 = vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(vget_high_u8(chg))));
+    d0 = vbicq_u16(vminq_u16(vqaddq_u16(d0, dtv), lim), c0);
+    d1 = vbicq_u16(vminq_u16(vqaddq_u16(d1, dtv), lim), c1);
+    vst1q_u16(deb, d0);
+    vst1q_u16(deb + 8, d1);
+
+    ready = vcombine_u8(vmovn_u16(vcgeq_u16(d0, lim)), vmovn_u16(vcgeq_u16(d1, lim)));
+    edge = vandq_u8(ready, vmvnq_u8(vceqq_u8(st, r)));
+    st = vbslq_u8(edge, r, st);
+    vst1q_u8(stable, st);
+
+    attn = vorrq_u8(vorrq_u8(chg, edge), vtstq_u8(b, b));
+
+    /* NEON 没有 movemask：按位权相与后逐级两两相加 */
+    sum = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vandq_u8(attn, vld1q_u8(bit_weight)))));
+    return (uint32_t)vgetq_lane_u64(sum, 0) | ((uint32_t)vgetq_lane_u64(sum, 1) << 8);
+}
+
+static uint32_t kb_simd_block(const uint8_t *raw, uint8_t *raw_last, uint8_t *stable,
+                              uint16_t *deb, const uint8_t *busy, uint16_t dt16, uint16_t lim16)
+{
+    const uint16x8_t dtv = vdupq_n_u16(dt16);
+    const uint16x8_t lim = vdupq_n_u16(lim16);
+    uint32_t lo = kb_neon_block16(raw, raw_last, stable, deb, busy, dtv, lim);
+    uint32_t hi = kb_neon_block16(raw + 16, raw_last + 16, stable + 16, deb + 16, busy + 16, dtv, lim);
+
+    return lo | (hi << 16);
+}
+
+#else
+
+/* 可移植标量实现：没有可用指令集时使用，结果与向量版本逐位一致 */
+static uint32_t kb_simd_block(const uint8_t *raw, uint8_t *raw_last, uint8_t *stable,
+                              uint16_t *deb, const uint8_t *busy, uint16_t dt16, uint16_t lim16)
+{
+    uint32_t attn = 0u;
+    uint8_t i;
+
+    for (i = 0u; i < KB_SIMD_BLOCK; i++)
+    {
+        uint8_t r = (uint8_t)(raw[i] ? 1u : 0u);
+        uint8_t chg = (uint8_t)(r != raw_last[i]);
+        uint8_t edge = 0u;
+
+        raw_last[i] = r;
+        if (chg != 0u)
+        {
+            deb[i] = 0u;
+        }
+        else
+        {
+            uint32_t d = (uint32_t)deb[i] + dt16;
+            deb[i] = (uint16_t)((d > lim16) ? lim16 : d);
+        }
+        if (deb[i] >= lim16 && stable[i] != r)
+        {
+            stable[i] = r;
+            edge = 1u;
+        }
+        if ((chg | edge | busy[i]) != 0u)
+        {
+            attn |= (uint32_t)1u << i;
+        }
+    }
+
+    return attn;
+}
+
+#endif
+
+void kb_simd_debounce(const uint8_t *raw, uint8_t *raw_last, uint8_t *stable, uint16_t *deb,
+                      const uint8_t *busy, uint32_t *attn, uint16_t n, uint32_t dt_ms)
+{
+    uint16_t dt16 = (uint16_t)((dt_ms > KB_DEBOUNCE_MS) ? KB_DEBOUNCE_MS : dt_ms);
+    uint32_t base;
+    uint16_t w = 0u;
+
+    for (base = 0u; base < n; base += KB_SIMD_BLOCK)
+    {
+        attn[w++] = kb_simd_block(raw + base, raw_last + base, stable + base, deb + base,
+                                  busy + base, dt16, (uint16_t)KB_DEBOUNCE_MS);
+    }
+}
+
+#endif /* KB_USING_SIMD */
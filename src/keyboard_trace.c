@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+
+#include "keyboard_trace.h"
+
+#if KB_USING_TRACE
+
+#define KB_TRACE_MIN_SIZE 16u
+
+static void kb_trace_put(keyboard_trace_t *tr, uint8_t b)
+{
+    tr->buf[tr->head] = b;
+    tr->head++;
+    if (tr->head >= tr->size)
+    {
+        tr->head = 0u;
+    }
+    tr->used++;
+}
+
+static uint32_t kb_trace_get_varint(const keyboard_trace_t *tr, uint32_t *pos)
+{
+    uint32_t value = 0u;
+    uint8_t shift = 0u;
+    uint8_t b;
+
+    do
+    {
+        b = tr->buf[*pos];
+        (*pos)++;
+        if (*pos >= tr->size)
+        {
+            *pos = 0u;
+        }
+        value |= (uint32_t)(b & 0x7Fu) << shift;
+        shift = (uint8_t)(shift + 7u);
+    } while ((b & 0x80u) != 0u && shift < 35u);
+
+    return value;
+}
+
+/* 丢弃最旧的一条记录，并把它携带的时间信息折算进 base_* */
+static void kb_trace_drop_oldest(keyboard_trace_t *tr)
+{
+    uint32_t pos = tr->tail;
+    uint8_t tag = tr->buf[pos];
+    uint32_t len;
+
+    pos++;
+    if (pos >= tr->size)
+    {
+        pos = 0u;
+    }
+
+    if ((tag >> 4) == KB_TRACE_REC_POLL)
+    {
+        if ((tag & 0x0Fu) == 0u)
+        {
+            tr->base_dt = kb_trace_get_varint(tr, &pos);
+            tr->base_time_ms += tr->base_dt;
+        }
+        else
+        {
+            tr->base_time_ms += tr->base_dt * (uint32_t)(tag & 0x0Fu);
+        }
+    }
+    else
+    {
+        (void)kb_trace_get_varint(tr, &pos);
+    }
+
+    len = (pos >= tr->tail) ? (pos - tr->tail) : (tr->size - tr->tail + pos);
+    tr->used -= len;
+    tr->tail = pos;
+    tr->flags |= KB_TRACE_FLAG_WRAPPED;
+}
+
+static void kb_trace_reserve(keyboard_trace_t *tr, uint32_t len)
+{
+    while (tr->size - tr->used < len)
+    {
+        kb_trace_drop_oldest(tr);
+    }
+}
+
+static void kb_trace_put_rec(keyboard_trace_t *tr, uint8_t tag, uint32_t value)
+{
+    uint8_t tmp[KB_TRACE_REC_MAX_LEN];
+    uint8_t n = 0u;
+    uint8_t i;
+
+    tmp[n++] = tag;
+    do
+    {
+        uint8_t b = (uint8_t)(value & 0x7Fu);
+        value >>= 7;
+        if (value != 0u)
+        {
+            b |= 0x80u;
+        }
+        tmp[n++] = b;
+    } while (value != 0u);
+
+    kb_trace_reserve(tr, n);
+    for (i = 0u; i < n; i++)
+    {
+        kb_trace_put(tr, tmp[i]);
+    }
+}
+
+int keyboard_trace_start(keyboard_control_t *ctl, keyboard_trace_t *tr, uint8_t *buf, uint32_t size)
+{
+    if (ctl == NULL || tr == NULL || buf == NULL || size < KB_TRACE_MIN_SIZE)
+    {
+        return KB_ERR_PARAM;
+    }
+
+    tr->buf = buf;
+    tr->size = size;
+    keyboard_trace_clear(tr);
+    if (ctl->polled == 0u)
+    {
+        tr->flags |= KB_TRACE_FLAG_FROM_INIT;
+    }
+    ctl->trace = tr;
+
+    return KB_OK;
+}
+
+void keyboard_trace_stop(keyboard_control_t *ctl)
+{
+    if (ctl != NULL)
+    {
+        ctl->trace = NULL;
+    }
+}
+
+void keyboard_trace_clear(keyboard_trace_t *tr)
+{
+    if (tr == NULL)
+    {
+        return;
+    }
+
+    tr->head = 0u;
+    tr->tail = 0u;
+    tr->used = 0u;
+    tr->last_dt = 0u;
+    tr->run_pos = 0u;
+    tr->run_valid = 0u;
+    tr->flags = 0u;
+    tr->base_dt = 0u;
+    tr->base_time_ms = 0u;
+}
+
+void keyboard_trace_on_poll(keyboard_trace_t *tr, uint32_t dt_ms)
+{
+    if (dt_ms == tr->last_dt)
+    {
+        /* 与上一次 dt 相同：优先在最后一条 POLL 记录上累加次数，空闲时每秒只有几个字节 */
+        if (tr->run_valid != 0u && (tr->buf[tr->run_pos] & 0x0Fu) < KB_TRACE_POLL_RUN_MAX)
+        {
+            tr->buf[tr->run_pos]++;
+            return;
+        }
+        kb_trace_reserve(tr, 1u);
+        tr->run_pos = tr->head;
+        tr->run_valid = 1u;
+        kb_trace_put(tr, (uint8_t)((KB_TRACE_REC_POLL << 4) | 1u));
+        return;
+    }
+
+    kb_trace_put_rec(tr, (uint8_t)(KB_TRACE_REC_POLL << 4), dt_ms);
+    tr->last_dt = dt_ms;
+    tr->run_valid = 0u;
+}
+
+void keyboard_trace_on_raw(keyboard_trace_t *tr, uint16_t idx, uint8_t level)
+{
+    kb_trace_put_rec(tr, (uint8_t)((KB_TRACE_REC_RAW << 4) | (level & 0x01u)), idx);
+    tr->run_valid = 0u;
+}
+
+void keyboard_trace_on_event(keyboard_trace_t *tr, uint16_t idx, kb_event_t evt)
+{
+    kb_trace_put_rec(tr, (uint8_t)((KB_TRACE_REC_EVT << 4) | ((uint8_t)evt & 0x0Fu)), idx);
+    tr->run_valid = 0u;
+}
+
+static void kb_trace_put_le(uint8_t *p, uint32_t v, uint8_t n)
+{
+    uint8_t i;
+
+    for (i = 0u; i < n; i++)
+    {
+        p[i] = (uint8_t)(v >> (8u * i));
+    }
+}
+
+static void kb_trace_write_chunked(keyboard_trace_write_fn write, void *user, const uint8_t *data, uint32_t len)
+{
+    while (len > 0u)
+    {
+        uint16_t n = (len > 0xFFFFu) ? 0xFFFFu : (uint16_t)len;
+        write(data, n, user);
+        data += n;
+        len -= n;
+    }
+}
+
+int keyboard_trace_dump(const keyboard_control_t *ctl, keyboard_trace_write_fn write, void *user)
+{
+    const keyboard_trace_t *tr;
+    const keyboard_que_t *node;
+    uint8_t hdr[KB_TRACE_HDR_LEN];
+    uint8_t id_buf[2];
+
+    if (ctl == NULL || ctl->trace == NULL || write == NULL)
+    {
+        return KB_ERR_PARAM;
+    }
+    tr = ctl->trace;
+
+    memcpy(hdr, KB_TRACE_MAGIC, 4u);
+    hdr[4] = tr->flags;
+    kb_trace_put_le(&hdr[5], ctl->key_num, 2u);
+    kb_trace_put_le(&hdr[7], tr->base_dt, 4u);
+    kb_trace_put_le(&hdr[11], tr->base_time_ms, 4u);
+    kb_trace_put_le(&hdr[15], tr->used, 4u);
+    hdr[19] = KB_TRACE_FEATURES;
+    kb_trace_put_le(&hdr[20], KB_DEBOUNCE_MS, 4u);
+    kb_trace_put_le(&hdr[24], KB_LONGPRESS_MS, 4u);
+    kb_trace_put_le(&hdr[28], KB_REPEAT_START_MS, 4u);
+    kb_trace_put_le(&hdr[32], KB_REPEAT_PERIOD_MS, 4u);
+    kb_trace_put_le(&hdr[36], KB_DOUBLE_CLICK_MS, 4u);
+    write(hdr, (uint16_t)sizeof(hdr), user);
+
+    for (node = ctl->head; node != NULL; node = node->next)
+    {
+        kb_trace_put_le(id_buf, node->key_id, 2u);
+        write(id_buf, 2u, user);
+    }
+
+    if (tr->used == 0u)
+    {
+        return KB_OK;
+    }
+    if (tr->tail < tr->head)
+    {
+        kb_trace_write_chunked(write, user, &tr->buf[tr->tail], tr->used);
+    }
+    else
+    {
+        kb_trace_write_chunked(write, user, &tr->buf[tr->tail], tr->size - tr->tail);
+        kb_trace_write_chunked(write, user, tr->buf, tr->head);
+    }
+
+    return KB_OK;
+}
+
+#endif /* KB_USING_TRACE */
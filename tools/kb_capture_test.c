@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+
+/*
+ * 输入捕获引擎时序测试：同一组边沿（无抖动的单次按下、两次短按）分别以不同的 poll 周期驱动 keyboard_poll()，
+ * 边沿时刻带随机的亚毫秒相位，松开/第二次按下常落在两次 poll 之间。检查：
+ * - 长按只取决于“松开确认时刻 - 按下边沿”是否达到 KB_LONGPRESS_MS
+ * - 双击只取决于“第二次按下确认时刻 - 第一次松开边沿”是否在 KB_DOUBLE_CLICK_MS 之内
+ * - 除 REPEAT 外的事件序列与 1 ms poll 完全相同
+ * 不一致时打印现场并返回 1。
+ *
+ * 用法: kb_capture_test [-s seed]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "keyboard_driver.h"
+#include "kb_trace_reader.h"
+
+#if (KB_BACKEND_MODE != KB_BACKEND_CAPTURE)
+#error "kb_capture_test must be built with KB_BACKEND_MODE=KB_BACKEND_CAPTURE"
+#endif
+
+#define CAP_EVT_MAX 64u
+#define CAP_EDGE_MAX 4u
+
+typedef struct
+{
+    uint32_t time_us;
+    uint8_t level;
+} cap_edge_t;
+
+typedef struct
+{
+    uint8_t evt[CAP_EVT_MAX];
+    uint8_t num;
+} cap_seq_t;
+
+static const uint32_t cap_period[] = { 1u, 3u, 10u, 20u, 50u, 100u };
+
+static uint32_t cap_seed;
+static uint32_t cap_rng;
+static uint32_t cap_tick;
+static cap_seq_t cap_seq;
+
+static uint32_t cap_rand(void)
+{
+    cap_rng ^= cap_rng << 13;
+    cap_rng ^= cap_rng >> 17;
+    cap_rng ^= cap_rng << 5;
+    return cap_rng;
+}
+
+static uint32_t cap_tick_us(void)
+{
+    return cap_tick;
+}
+
+static void cap_on_event(const char *keyname, uint16_t key_id, kb_event_t evt, void *user)
+{
+    (void)keyname;
+    (void)key_id;
+    (void)user;
+
+    /* 连发次数取决于 dt 与连发周期的关系，不参与比较 */
+    if (evt != KB_EVT_REPEAT && cap_seq.num < CAP_EVT_MAX)
+    {
+        cap_seq.evt[cap_seq.num++] = (uint8_t)evt;
+    }
+}
+
+/* 按 period_ms 周期 poll，边沿在其发生时刻之后的第一次 poll 之前上报 */
+static void cap_run(const cap_edge_t *edge, uint8_t edge_num, uint32_t period_ms, cap_seq_t *out)
+{
+    keyboard_control_t ctl;
+    keyboard_ops_t ops;
+    keyboard_cb_t cb;
+    keyboard_key_cfg_t cfg;
+    uint32_t end_us = edge[edge_num - 1u].time_us + (KB_DEBOUNCE_MS + KB_DOUBLE_CLICK_MS + 2u * period_ms) * 1000u;
+    uint8_t e = 0u;
+
+    memset(&ops, 0, sizeof(ops));
+    memset(&cb, 0, sizeof(cb));
+    memset(&cfg, 0, sizeof(cfg));
+    ops.get_tick_us = cap_tick_us;
+    cb.on_event = cap_on_event;
+    cap_tick = 0u;
+    cap_seq.num = 0u;
+    (void)keyboard_init(&ctl, &ops, &cb);
+    cfg.keyname = "K";
+    cfg.key_id = 1u;
+    cfg.hw.hw_code = 0u;
+    (void)keyboard_register_key(&cfg, &ctl);
+
+    while (cap_tick < end_us)
+    {
+        cap_tick += period_ms * 1000u;
+        while (e < edge_num && edge[e].time_us <= cap_tick)
+        {
+            (void)keyboard_capture_edge(&ctl, 0u, edge[e].level, edge[e].time_us);
+            e++;
+        }
+        keyboard_poll(&ctl, period_ms);
+    }
+    *out = cap_seq;
+}
+
+static uint8_t cap_has(const cap_seq_t *seq, kb_event_t evt)
+{
+    uint8_t i;
+
+    for (i = 0u; i < seq->num; i++)
+    {
+        if (seq->evt[i] == (uint8_t)evt)
+        {
+            return 1u;
+        }
+    }
+    return 0u;
+}
+
+static void cap_dump(const char *who, const cap_seq_t *seq)
+{
+    uint8_t i;
+
+    fprintf(stderr, "  %s:", who);
+    for (i = 0u; i < seq->num; i++)
+    {
+        fprintf(stderr, " %s", kb_trace_evt_name(seq->evt[i]));
+    }
+    fprintf(stderr, "\n");
+}
+
+/*
+ * expect_evt 为 KB_EVT_NUM 时不检查；否则 expect 表示该事件是否应当出现。
+ * 各 poll 周期的结果都与 1 ms poll 比较
+ */
+static int cap_check(const cap_edge_t *edge, uint8_t edge_num, kb_event_t expect_evt, uint8_t expect)
+{
+    cap_seq_t ref;
+    cap_seq_t dut;
+    uint32_t i;
+
+    for (i = 0u; i < sizeof(cap_period) / sizeof(cap_period[0]); i++)
+    {
+        cap_run(edge, edge_num, cap_period[i], (i == 0u) ? &ref : &dut);
+        if (i == 0u)
+        {
+            dut = ref;
+        }
+        if ((expect_evt != KB_EVT_NUM && cap_has(&dut, expect_evt) != expect) ||
+            dut.num != ref.num || memcmp(dut.evt, ref.evt, ref.num) != 0)
+        {
+            uint8_t k;
+
+            fprintf(stderr, "seed %u: poll %u ms, %s expected %s, edges:", (unsigned)cap_seed,
+                    (unsigned)cap_period[i], kb_trace_evt_name((uint8_t)expect_evt), expect ? "yes" : "no");
+            for (k = 0u; k < edge_num; k++)
+            {
+                fprintf(stderr, " %u@%u.%03u", edge[k].level, (unsigned)(edge[k].time_us / 1000u),
+                        (unsigned)(edge[k].time_us % 1000u));
+            }
+            fprintf(stderr, "\n");
+            cap_dump("1 ms", &ref);
+            cap_dump("dut ", &dut);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* 计时按整毫秒推进，离阈值 2 ms 以内的情况不判定 */
+static uint8_t cap_near(uint32_t a_ms, uint32_t b_ms)
+{
+    return (uint8_t)((a_ms > b_ms ? a_ms - b_ms : b_ms - a_ms) <= 2u);
+}
+
+int main(int argc, char **argv)
+{
+    cap_edge_t edge[CAP_EDGE_MAX];
+    uint32_t cases = 0u;
+    uint32_t seed = 1u;
+    uint32_t d;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            seed = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-s seed]\n", argv[0]);
+            return 2;
+        }
+    }
+    cap_seed = seed;
+    cap_rng = (seed != 0u) ? seed : 1u;
+
+    /* 单次按下：时长从去抖时间扫到长按阈值之后 */
+    for (d = 2u * KB_DEBOUNCE_MS; d < KB_LONGPRESS_MS + 200u; d += 3u)
+    {
+        uint32_t press_us = 100000u + cap_rand() % 100000u;
+        uint32_t held_ms = d + KB_DEBOUNCE_MS;
+
+        edge[0].time_us = press_us;
+        edge[0].level = 1u;
+        edge[1].time_us = press_us + d * 1000u + cap_rand() % 1000u;
+        edge[1].level = 0u;
+#if KB_USING_LONGPRESS
+        if (!cap_near(held_ms, KB_LONGPRESS_MS) &&
+            cap_check(edge, 2u, KB_EVT_LONGPRESS, (uint8_t)(held_ms >= KB_LONGPRESS_MS)) != 0)
+#else
+        (void)held_ms;
+        if (cap_check(edge, 2u, KB_EVT_NUM, 0u) != 0)
+#endif
+        {
+            return 1;
+        }
+        cases++;
+    }
+
+    /* 两次短按：间隔扫过双击窗口 */
+    for (d = 2u * KB_DEBOUNCE_MS; d < KB_DOUBLE_CLICK_MS + 100u; d += 3u)
+    {
+        uint32_t press_us = 100000u + cap_rand() % 100000u;
+        uint32_t gap_ms = d + KB_DEBOUNCE_MS;
+
+        edge[0].time_us = press_us;
+        edge[0].level = 1u;
+        edge[1].time_us = edge[0].time_us + (2u * KB_DEBOUNCE_MS) * 1000u + cap_rand() % 1000u;
+        edge[1].level = 0u;
+        edge[2].time_us = edge[1].time_us + d * 1000u + cap_rand() % 1000u;
+        edge[2].level = 1u;
+        edge[3].time_us = edge[2].time_us + (2u * KB_DEBOUNCE_MS) * 1000u + cap_rand() % 1000u;
+        edge[3].level = 0u;
+#if KB_USING_DOUBLE_CLICK
+        if (!cap_near(gap_ms, KB_DOUBLE_CLICK_MS) &&
+            cap_check(edge, 4u, KB_EVT_DOUBLE_CLICK, (uint8_t)(gap_ms < KB_DOUBLE_CLICK_MS)) != 0)
+#else
+        (void)gap_ms;
+        if (cap_check(edge, 4u, KB_EVT_NUM, 0u) != 0)
+#endif
+        {
+            return 1;
+        }
+        cases++;
+    }
+
+    printf("%u cases x %u poll periods: ok\n", (unsigned)cases, (unsigned)(sizeof(cap_period) / sizeof(cap_period[0])));
+    return 0;
+}
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+
+/*
+ * 差分测试：用同一份随机输入（带抖动的按下/松开 + 随机 dt）同时驱动 keyboard_poll()
+ * 和参考模型 kb_ref_engine，逐次 poll 比较事件序列（KB_USING_TIMESTAMP 下逐按键比较），不一致时打印现场并返回 1。
+ *
+ * 用法: kb_diff [-s seed] [-r runs] [-n polls]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "keyboard_driver.h"
+#include "kb_ref_engine.h"
+#include "kb_trace_reader.h"
+
+#if (KB_BACKEND_MODE != KB_BACKEND_CUSTOM)
+#error "kb_diff must be built with KB_BACKEND_MODE=KB_BACKEND_CUSTOM"
+#endif
+
+#define DIFF_EVT_MAX (KB_MAX_KEYS * 4u)
+
+static uint32_t diff_rng;
+static uint8_t diff_raw[KB_MAX_KEYS];
+static uint8_t diff_level[KB_MAX_KEYS];
+static uint8_t diff_bounce[KB_MAX_KEYS];
+static kb_ref_key_t diff_ref_keys[KB_MAX_KEYS];
+static kb_ref_evt_t diff_ref_evt[DIFF_EVT_MAX];
+static kb_ref_evt_t diff_dut_evt[DIFF_EVT_MAX];
+static uint32_t diff_dut_num;
+
+static uint32_t diff_rand(void)
+{
+    diff_rng ^= diff_rng << 13;
+    diff_rng ^= diff_rng >> 17;
+    diff_rng ^= diff_rng << 5;
+    return diff_rng;
+}
+
+static uint32_t diff_dt(void)
+{
+    static const uint32_t edge_dt[] = {
+        KB_DEBOUNCE_MS, KB_DOUBLE_CLICK_MS, KB_DOUBLE_CLICK_MS - 1u, KB_LONGPRESS_MS,
+        KB_REPEAT_START_MS, KB_REPEAT_PERIOD_MS, KB_REPEAT_PERIOD_MS - 1u, 1u
+    };
+    uint32_t r = diff_rand() % 100u;
+
+    if (r < 80u)
+    {
+        return 10u;
+    }
+    if (r < 95u)
+    {
+        return 1u + diff_rand() % 40u;
+    }
+    return edge_dt[diff_rand() % (sizeof(edge_dt) / sizeof(edge_dt[0]))];
+}
+
+static void diff_step_input(uint16_t key_num)
+{
+    uint16_t i;
+
+    for (i = 0u; i < key_num; i++)
+    {
+        if (diff_rand() % 1000u < 15u)
+        {
+            diff_level[i] ^= 1u;
+            diff_bounce[i] = (uint8_t)(diff_rand() % 4u);
+        }
+        if (diff_bounce[i] != 0u)
+        {
+            diff_bounce[i]--;
+            diff_raw[i] = (uint8_t)(diff_rand() & 1u);
+        }
+        else
+        {
+            diff_raw[i] = diff_level[i];
+        }
+    }
+}
+
+static int diff_snapshot(uint8_t *state_buf, uint16_t key_count)
+{
+    memcpy(state_buf, diff_raw, key_count);
+    return 0;
+}
+
+static void diff_on_event(const char *keyname, uint16_t key_id, kb_event_t evt, void *user)
+{
+    (void)keyname;
+    (void)user;
+
+    if (diff_dut_num < DIFF_EVT_MAX)
+    {
+        diff_dut_evt[diff_dut_num].idx = (uint16_t)(key_id - 1u);
+        diff_dut_evt[diff_dut_num].evt = evt;
+    }
+    diff_dut_num++;
+}
+
+static void diff_dump(const char *who, const kb_ref_evt_t *evt, uint32_t num)
+{
+    uint32_t i;
+
+    fprintf(stderr, "  %s:", who);
+    for (i = 0u; i < num && i < DIFF_EVT_MAX; i++)
+    {
+        fprintf(stderr, " %u:%s", evt[i].idx, kb_trace_evt_name((uint8_t)evt[i].evt));
+    }
+    fprintf(stderr, "\n");
+}
+
+#if KB_USING_TIMESTAMP
+/* 按按键下标稳定排序：同一按键的事件保持原顺序 */
+static void diff_sort_by_key(kb_ref_evt_t *evt, uint32_t num)
+{
+    uint32_t i;
+
+    for (i = 1u; i < num; i++)
+    {
+        kb_ref_evt_t e = evt[i];
+        uint32_t j = i;
+
+        while (j > 0u && evt[j - 1u].idx > e.idx)
+        {
+            evt[j] = evt[j - 1u];
+            j--;
+        }
+        evt[j] = e;
+    }
+}
+#endif
+
+/*
+ * 比较一次 poll 的事件序列。KB_USING_TIMESTAMP 下驱动按发生时刻对不同按键的事件重新排序，
+ * 参考模型仍按按键顺序输出，因此只比较每个按键各自的事件序列
+ */
+static int diff_same(uint32_t ref_num)
+{
+#if KB_USING_TIMESTAMP
+    static kb_ref_evt_t ref_sorted[DIFF_EVT_MAX];
+    static kb_ref_evt_t dut_sorted[DIFF_EVT_MAX];
+    const kb_ref_evt_t *ref = ref_sorted;
+    const kb_ref_evt_t *dut = dut_sorted;
+#else
+    const kb_ref_evt_t *ref = diff_ref_evt;
+    const kb_ref_evt_t *dut = diff_dut_evt;
+#endif
+    uint32_t i;
+
+    if (ref_num != diff_dut_num || ref_num > DIFF_EVT_MAX)
+    {
+        return 0;
+    }
+#if KB_USING_TIMESTAMP
+    memcpy(ref_sorted, diff_ref_evt, sizeof(kb_ref_evt_t) * ref_num);
+    memcpy(dut_sorted, diff_dut_evt, sizeof(kb_ref_evt_t) * ref_num);
+    diff_sort_by_key(ref_sorted, ref_num);
+    diff_sort_by_key(dut_sorted, ref_num);
+#endif
+    /* 逐字段比较，kb_ref_evt_t 中的填充字节不参与 */
+    for (i = 0u; i < ref_num; i++)
+    {
+        if (ref[i].idx != dut[i].idx || ref[i].evt != dut[i].evt)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int diff_run(uint32_t seed, uint32_t polls)
+{
+    keyboard_control_t ctl;
+    keyboard_ops_t ops;
+    keyboard_cb_t cb;
+    kb_ref_t ref;
+    uint16_t key_num;
+    uint16_t i;
+    uint32_t n;
+
+    diff_rng = seed ? seed : 1u;
+    memset(diff_raw, 0, sizeof(diff_raw));
+    memset(diff_level, 0, sizeof(diff_level));
+    memset(diff_bounce, 0, sizeof(diff_bounce));
+
+    memset(&ops, 0, sizeof(ops));
+    ops.scan_snapshot = diff_snapshot;
+    cb.on_event = diff_on_event;
+    cb.user = NULL;
+    if (keyboard_init(&ctl, &ops, &cb) != KB_OK)
+    {
+        return -1;
+    }
+    key_num = (uint16_t)(1u + diff_rand() % KB_MAX_KEYS);
+    for (i = 0u; i < key_num; i++)
+    {
+        keyboard_key_cfg_t cfg;
+
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.keyname = "K";
+        cfg.key_id = (uint16_t)(i + 1u);
+        cfg.hw.hw_code = i;
+#if KB_USING_HYBRID
+        cfg.backend = KB_BACKEND_CUSTOM;
+#endif
+        if (keyboard_register_key(&cfg, &ctl) != KB_OK)
+        {
+            key_num = i;
+            break;
+        }
+    }
+    kb_ref_init(&ref, diff_ref_keys, key_num);
+
+    for (n = 0u; n < polls; n++)
+    {
+        uint32_t dt = diff_dt();
+        uint32_t ref_num;
+
+        diff_step_input(key_num);
+        diff_dut_num = 0u;
+        keyboard_poll(&ctl, dt);
+        ref_num = kb_ref_poll(&ref, diff_raw, dt, diff_ref_evt, DIFF_EVT_MAX);
+
+        if (!diff_same(ref_num))
+        {
+            fprintf(stderr, "seed %u: %u keys, poll %u (dt=%u): event sequences differ\n",
+                    (unsigned)seed, key_num, (unsigned)n, (unsigned)dt);
+            diff_dump("reference", diff_ref_evt, ref_num);
+            diff_dump("keyboard ", diff_dut_evt, diff_dut_num);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t seed = 1u;
+    uint32_t runs = 200u;
+    uint32_t polls = 20000u;
+    uint32_t r;
+    int k;
+
+    for (k = 1; k + 1 < argc; k += 2)
+    {
+        if (strcmp(argv[k], "-s") == 0)
+        {
+            seed = (uint32_t)strtoul(argv[k + 1], NULL, 0);
+        }
+        else if (strcmp(argv[k], "-r") == 0)
+        {
+            runs = (uint32_t)strtoul(argv[k + 1], NULL, 0);
+        }
+        else if (strcmp(argv[k], "-n") == 0)
+        {
+            polls = (uint32_t)strtoul(argv[k + 1], NULL, 0);
+        }
+    }
+
+    for (r = 0u; r < runs; r++)
+    {
+        if (diff_run(seed + r, polls) != 0)
+        {
+            return 1;
+        }
+    }
+
+    printf("%u runs x %u polls: identical\n", (unsigned)runs, (unsigned)polls);
+    return 0;
+}
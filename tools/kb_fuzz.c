@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+
+/*
+ * 事件状态机模糊测试：把任意输入解释为按键数量 + 一串 (dt, 原始电平) 步骤驱动 keyboard_poll()，
+ * 并检查以下不变量，违反时 abort()：
+ * - 事件只出现在已注册的按键上
+ * - 每个按键的 PRESS/RELEASE 交替出现，最终每个 PRESS 都有对应的 RELEASE
+ * - LONGPRESS/REPEAT 只在按下期间出现，一次按下最多一个 LONGPRESS
+ * - LONGPRESS_RELEASE 只紧跟在长按后的 RELEASE 之后
+ * - CLICK/DOUBLE_CLICK 只在松开状态出现
+ * - 没有因 pending_evt 满而丢弃的事件
+ * - KB_USING_DEFERRED_DISPATCH 下每次 poll 后 keyboard_dispatch() 都把队列取空，且队列没有丢弃
+ *   （按键数限制在 KB_EVENT_QUEUE_LEN / 4 以内，一次 poll 的事件不会超过队列长度）
+ *
+ * 输入格式：byte0 = 按键数量；之后每步 1 字节 dt + ceil(按键数/8) 字节电平位图。
+ * dt 字节 >= 0xF0 时取特殊值（恰好等于各时间参数及其 ±1），便于覆盖边界。
+ *
+ * libFuzzer: clang -fsanitize=fuzzer,address -DKB_FUZZ_LIBFUZZER ...
+ * AFL/普通 Linux: 不定义 KB_FUZZ_LIBFUZZER，从文件参数或 stdin 读取输入
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "keyboard_driver.h"
+
+#if (KB_BACKEND_MODE != KB_BACKEND_CUSTOM)
+#error "kb_fuzz must be built with KB_BACKEND_MODE=KB_BACKEND_CUSTOM"
+#endif
+
+#define FUZZ_KEY_ID(i)  ((uint16_t)(0x100u + (i) * 3u))
+#define FUZZ_BITMAP_LEN ((KB_MAX_KEYS + 7u) / 8u)
+
+/* 每个按键一次 poll 最多产生 4 个事件；延迟分发时按键数不超过队列能装下的数量 */
+#if KB_USING_DEFERRED_DISPATCH && (KB_EVENT_QUEUE_LEN / 4u < KB_MAX_KEYS)
+#define FUZZ_MAX_KEYS   (KB_EVENT_QUEUE_LEN / 4u)
+#else
+#define FUZZ_MAX_KEYS   KB_MAX_KEYS
+#endif
+
+typedef struct
+{
+    uint8_t pressed;
+    uint8_t long_sent;
+    uint8_t expect_long_release;
+} fuzz_key_t;
+
+static uint8_t fuzz_raw[KB_MAX_KEYS];
+static fuzz_key_t fuzz_key[KB_MAX_KEYS];
+static uint16_t fuzz_key_num;
+
+static const uint32_t fuzz_special_dt[16] = {
+    KB_DEBOUNCE_MS, KB_DEBOUNCE_MS - 1u, KB_DEBOUNCE_MS + 1u,
+    KB_DOUBLE_CLICK_MS, KB_DOUBLE_CLICK_MS - 1u, KB_DOUBLE_CLICK_MS + 1u,
+    KB_LONGPRESS_MS, KB_LONGPRESS_MS - 1u, KB_LONGPRESS_MS + 1u,
+    KB_REPEAT_START_MS, KB_REPEAT_START_MS - 1u,
+    KB_REPEAT_PERIOD_MS, KB_REPEAT_PERIOD_MS - 1u,
+    KB_DOUBLE_CLICK_MS / 2u, 0xFFFFu, 0x7FFFFFFFu
+};
+
+static void fuzz_check(int cond, const char *what, uint16_t idx, kb_event_t evt)
+{
+    if (!cond)
+    {
+        fprintf(stderr, "invariant violated: %s (key %u, evt %d)\n", what, idx, (int)evt);
+        abort();
+    }
+}
+
+static int fuzz_snapshot(uint8_t *state_buf, uint16_t key_count)
+{
+    memcpy(state_buf, fuzz_raw, key_count);
+    return 0;
+}
+
+static void fuzz_on_event(const char *keyname, uint16_t key_id, kb_event_t evt, void *user)
+{
+    fuzz_key_t *k;
+    uint16_t idx;
+
+    (void)keyname;
+    (void)user;
+
+    idx = (uint16_t)((key_id - 0x100u) / 3u);
+    fuzz_check(key_id >= 0x100u && (key_id - 0x100u) % 3u == 0u && idx < fuzz_key_num,
+               "event on unregistered key", key_id, evt);
+    k = &fuzz_key[idx];
+
+    if (evt != KB_EVT_LONGPRESS_RELEASE)
+    {
+        fuzz_check(k->expect_long_release == 0u, "LONGPRESS_RELEASE missing after RELEASE", idx, evt);
+    }
+
+    switch (evt)
+    {
+    case KB_EVT_PRESS:
+        fuzz_check(k->pressed == 0u, "PRESS while pressed", idx, evt);
+        k->pressed = 1u;
+        k->long_sent = 0u;
+        break;
+    case KB_EVT_RELEASE:
+        fuzz_check(k->pressed != 0u, "RELEASE without PRESS", idx, evt);
+        k->pressed = 0u;
+        k->expect_long_release = k->long_sent;
+        break;
+    case KB_EVT_LONGPRESS:
+        fuzz_check(k->pressed != 0u && k->long_sent == 0u, "LONGPRESS outside a single press", idx, evt);
+        k->long_sent = 1u;
+        break;
+    case KB_EVT_LONGPRESS_RELEASE:
+        fuzz_check(k->expect_long_release != 0u, "LONGPRESS_RELEASE without long press", idx, evt);
+        k->expect_long_release = 0u;
+        break;
+    case KB_EVT_REPEAT:
+        fuzz_check(k->pressed != 0u, "REPEAT while released", idx, evt);
+        break;
+    case KB_EVT_CLICK:
+    case KB_EVT_DOUBLE_CLICK:
+        fuzz_check(k->pressed == 0u && k->long_sent == 0u, "click on a long press or while pressed", idx, evt);
+        break;
+    default:
+        fuzz_check(0, "unknown event", idx, evt);
+        break;
+    }
+}
+
+/* 延迟分发时回调在 keyboard_dispatch() 中执行：每次 poll 后取空队列 */
+static void fuzz_poll(keyboard_control_t *ctl, uint32_t dt)
+{
+    keyboard_poll(ctl, dt);
+    fuzz_check(ctl->evt_dropped == 0u, "pending_evt overflow", 0u, KB_EVT_PRESS);
+#if KB_USING_DEFERRED_DISPATCH
+    (void)keyboard_dispatch(ctl);
+    fuzz_check(ctl->evt_head == ctl->evt_tail, "dispatch left events queued", 0u, KB_EVT_PRESS);
+    fuzz_check(ctl->evt_queue_dropped == 0u, "event queue overflow", 0u, KB_EVT_PRESS);
+#endif
+}
+
+static void fuzz_one(const uint8_t *data, size_t size)
+{
+    keyboard_control_t ctl;
+    keyboard_ops_t ops;
+    keyboard_cb_t cb;
+    uint16_t bitmap_len;
+    uint16_t i;
+    size_t pos;
+
+    if (size < 1u)
+    {
+        return;
+    }
+
+    memset(fuzz_raw, 0, sizeof(fuzz_raw));
+    memset(fuzz_key, 0, sizeof(fuzz_key));
+    memset(&ops, 0, sizeof(ops));
+    ops.scan_snapshot = fuzz_snapshot;
+    cb.on_event = fuzz_on_event;
+    cb.user = NULL;
+    fuzz_check(keyboard_init(&ctl, &ops, &cb) == KB_OK, "keyboard_init failed", 0u, KB_EVT_PRESS);
+
+    fuzz_key_num = (uint16_t)(data[0] % FUZZ_MAX_KEYS + 1u);
+    for (i = 0u; i < fuzz_key_num; i++)
+    {
+        keyboard_key_cfg_t cfg;
+
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.keyname = "K";
+        cfg.key_id = FUZZ_KEY_ID(i);
+        cfg.hw.hw_code = i;
+#if KB_USING_HYBRID
+        cfg.backend = KB_BACKEND_CUSTOM;
+#endif
+        if (keyboard_register_key(&cfg, &ctl) != KB_OK)
+        {
+            /* 内存池容量小于 KB_MAX_KEYS 时按实际注册成功的数量测试 */
+            fuzz_key_num = i;
+            break;
+        }
+    }
+    if (fuzz_key_num == 0u)
+    {
+        return;
+    }
+    bitmap_len = (uint16_t)((fuzz_key_num + 7u) / 8u);
+
+    for (pos = 1u; pos + 1u + bitmap_len <= size; pos += 1u + bitmap_len)
+    {
+        uint8_t b = data[pos];
+        uint32_t dt = (b >= 0xF0u) ? fuzz_special_dt[b - 0xF0u] : b;
+
+        for (i = 0u; i < fuzz_key_num; i++)
+        {
+            fuzz_raw[i] = (uint8_t)((data[pos + 1u + i / 8u] >> (i % 8u)) & 1u);
+        }
+        fuzz_poll(&ctl, dt);
+    }
+
+    /* 全部松开并等待足够长时间，所有按下都必须已释放 */
+    memset(fuzz_raw, 0, sizeof(fuzz_raw));
+    for (i = 0u; i < 4u; i++)
+    {
+        fuzz_poll(&ctl, KB_DEBOUNCE_MS + KB_DOUBLE_CLICK_MS);
+    }
+    for (i = 0u; i < fuzz_key_num; i++)
+    {
+        fuzz_check(fuzz_key[i].pressed == 0u, "PRESS without matching RELEASE", i, KB_EVT_RELEASE);
+        fuzz_check(fuzz_key[i].expect_long_release == 0u, "LONGPRESS_RELEASE missing", i, KB_EVT_RELEASE);
+    }
+}
+
+#ifdef KB_FUZZ_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    fuzz_one(data, size);
+    return 0;
+}
+
+#else
+
+static int fuzz_file(FILE *fp)
+{
+    static uint8_t buf[1u << 20];
+    size_t n = fread(buf, 1u, sizeof(buf), fp);
+
+    fuzz_one(buf, n);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int i;
+
+    if (argc < 2)
+    {
+        return fuzz_file(stdin);
+    }
+    for (i = 1; i < argc; i++)
+    {
+        FILE *fp = fopen(argv[i], "rb");
+
+        if (fp == NULL)
+        {
+            perror(argv[i]);
+            return 2;
+        }
+        fuzz_file(fp);
+        fclose(fp);
+    }
+    return 0;
+}
+
+#endif /* KB_FUZZ_LIBFUZZER */
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+
+#include <string.h>
+#include "kb_ref_engine.h"
+
+static void kb_ref_push(kb_ref_evt_t *out, uint32_t max, uint32_t *num, uint16_t idx, kb_event_t evt)
+{
+    if (*num < max)
+    {
+        out[*num].idx = idx;
+        out[*num].evt = evt;
+    }
+    (*num)++;
+}
+
+void kb_ref_init(kb_ref_t *ref, kb_ref_key_t *keys, uint16_t key_num)
+{
+    ref->key_num = key_num;
+    ref->keys = keys;
+    memset(keys, 0, sizeof(*keys) * key_num);
+}
+
+uint32_t kb_ref_poll(kb_ref_t *ref, const uint8_t *raw_buf, uint32_t dt_ms, kb_ref_evt_t *out, uint32_t max)
+{
+    uint32_t num = 0u;
+    uint16_t idx;
+
+    if (dt_ms == 0u)
+    {
+        return 0u;
+    }
+
+    for (idx = 0u; idx < ref->key_num; idx++)
+    {
+        kb_ref_key_t *rt = &ref->keys[idx];
+        uint8_t raw = (uint8_t)(raw_buf[idx] ? 1u : 0u);
+
+        if (raw != rt->raw_last)
+        {
+            rt->raw_last = raw;
+            rt->debounce_ms = 0u;
+        }
+        else
+        {
+            if (rt->debounce_ms < KB_DEBOUNCE_MS)
+            {
+                rt->debounce_ms += dt_ms;
+            }
+        }
+
+        if (rt->debounce_ms >= KB_DEBOUNCE_MS && rt->stable != rt->raw_last)
+        {
+            rt->stable = rt->raw_last;
+            if (rt->stable != 0u)
+            {
+                rt->press_ms = 0u;
+                rt->repeat_ms = 0u;
+                rt->long_sent = 0u;
+
+                kb_ref_push(out, max, &num, idx, KB_EVT_PRESS);
+            }
+            else
+            {
+                kb_ref_push(out, max, &num, idx, KB_EVT_RELEASE);
+
+                if (rt->long_sent != 0u)
+                {
+                    kb_ref_push(out, max, &num, idx, KB_EVT_LONGPRESS_RELEASE);
+                    rt->click_count = 0u;
+                    rt->click_wait_ms = 0u;
+                }
+                else
+                {
+                    if (rt->click_count == 0u)
+                    {
+                        rt->click_count = 1u;
+                        rt->click_wait_ms = 0u;
+                    }
+                    else if (rt->click_count == 1u && rt->click_wait_ms <= KB_DOUBLE_CLICK_MS)
+                    {
+                        kb_ref_push(out, max, &num, idx, KB_EVT_DOUBLE_CLICK);
+                        rt->click_count = 0u;
+                        rt->click_wait_ms = 0u;
+                    }
+                    else
+                    {
+                        rt->click_count = 1u;
+                        rt->click_wait_ms = 0u;
+                    }
+                }
+
+                rt->press_ms = 0u;
+                rt->repeat_ms = 0u;
+                rt->long_sent = 0u;
+            }
+        }
+
+        if (rt->stable != 0u)
+        {
+            rt->press_ms += dt_ms;
+
+            if (rt->long_sent == 0u && rt->press_ms >= KB_LONGPRESS_MS)
+            {
+                rt->long_sent = 1u;
+                kb_ref_push(out, max, &num, idx, KB_EVT_LONGPRESS);
+            }
+
+            if (rt->press_ms >= KB_REPEAT_START_MS)
+            {
+                rt->repeat_ms += dt_ms;
+                if (rt->repeat_ms >= KB_REPEAT_PERIOD_MS)
+                {
+                    rt->repeat_ms = 0u;
+                    kb_ref_push(out, max, &num, idx, KB_EVT_REPEAT);
+                }
+            }
+        }
+        else
+        {
+            if (rt->click_count == 1u)
+            {
+                rt->click_wait_ms += dt_ms;
+                if (rt->click_wait_ms >= KB_DOUBLE_CLICK_MS)
+                {
+                    kb_ref_push(out, max, &num, idx, KB_EVT_CLICK);
+                    rt->click_count = 0u;
+                    rt->click_wait_ms = 0u;
+                }
+            }
+        }
+    }
+
+    return num;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+#ifndef MYCOMPONENTS_KEYBOARD_TOOLS_KB_REF_ENGINE_H_
+#define MYCOMPONENTS_KEYBOARD_TOOLS_KB_REF_ENGINE_H_
+
+#include <stdint.h>
+#include "keyboard_driver.h"
+
+/*
+ * 参考模型：保留 keyboard_poll() 最直接的逐键实现，不涉及硬件后端和回调，
+ * 只作为差分测试的行为基准。修改 keyboard_poll() 热路径时不要同步修改这里。
+ */
+typedef struct
+{
+    uint8_t raw_last;
+    uint8_t stable;
+    uint8_t long_sent;
+    uint8_t click_count;
+    uint32_t debounce_ms;
+    uint32_t press_ms;
+    uint32_t repeat_ms;
+    uint32_t click_wait_ms;
+} kb_ref_key_t;
+
+typedef struct
+{
+    uint16_t idx;
+    kb_event_t evt;
+} kb_ref_evt_t;
+
+typedef struct
+{
+    uint16_t key_num;
+    kb_ref_key_t *keys;
+} kb_ref_t;
+
+/* keys 由调用者提供，至少 key_num 个元素 */
+void kb_ref_init(kb_ref_t *ref, kb_ref_key_t *keys, uint16_t key_num);
+
+/* 用 raw[0..key_num) 推进一次，事件写入 out（最多 max 个），返回事件总数 */
+uint32_t kb_ref_poll(kb_ref_t *ref, const uint8_t *raw, uint32_t dt_ms, kb_ref_evt_t *out, uint32_t max);
+
+#endif /* MYCOMPONENTS_KEYBOARD_TOOLS_KB_REF_ENGINE_H_ */
@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+
+/*
+ * 录制/回放工具：把 trace dump 中的原始电平按记录的 dt 逐次喂给 keyboard_poll()，
+ * 并把产生的事件流与黄金文件逐字节比较。重构 poll 热路径前后各跑一遍即可确认行为不变。
+ *
+ * 用法:
+ *   kb_replay <dump.bin> -o golden.txt    生成事件流
+ *   kb_replay <dump.bin> -g golden.txt    与黄金文件比较，不一致时返回 1
+ *
+ * 同时会检查回放产生的事件与 dump 中录制的事件是否一致。
+ * 需要以 KB_BACKEND_MODE=KB_BACKEND_CUSTOM 编译，KB_MAX_KEYS 不小于 dump 中的按键数，
+ * 事件检测开关和时间参数与录制端相同；dump 必须从初始化开始记录且未发生覆盖。
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "keyboard_driver.h"
+#include "keyboard_trace.h"
+#include "kb_trace_reader.h"
+
+#if (KB_BACKEND_MODE != KB_BACKEND_CUSTOM)
+#error "kb_replay must be built with KB_BACKEND_MODE=KB_BACKEND_CUSTOM"
+#endif
+
+#define REPLAY_EXPECT_MAX (KB_MAX_KEYS * 4u)
+
+typedef struct
+{
+    uint16_t idx;
+    uint8_t evt;
+} replay_evt_t;
+
+typedef struct
+{
+    kb_trace_reader_t rd;
+    uint8_t raw[KB_MAX_KEYS];
+    char names[KB_MAX_KEYS][8];
+    uint32_t time_ms;
+
+    /* 当前 poll 录制的事件 */
+    replay_evt_t expect[REPLAY_EXPECT_MAX];
+    uint16_t expect_num;
+    uint16_t expect_pos;
+
+    FILE *out;
+    FILE *golden;
+    unsigned long out_bytes;
+    int mismatch;
+} replay_t;
+
+static replay_t rp;
+
+static int replay_snapshot(uint8_t *state_buf, uint16_t key_count)
+{
+    memcpy(state_buf, rp.raw, key_count);
+    return 0;
+}
+
+static void replay_fail(const char *what)
+{
+    if (rp.mismatch == 0)
+    {
+        fprintf(stderr, "mismatch at t=%u ms (stream byte %lu): %s\n",
+                (unsigned)rp.time_ms, rp.out_bytes, what);
+    }
+    rp.mismatch = 1;
+}
+
+static void replay_on_event(const char *keyname, uint16_t key_id, kb_event_t evt, void *user)
+{
+    char line[64];
+    char ref[64];
+    int len;
+    uint16_t idx = 0u;
+
+    (void)keyname;
+    (void)user;
+
+    while (idx < rp.rd.key_num && rp.rd.key_ids[idx] != key_id)
+    {
+        idx++;
+    }
+
+    if (rp.expect_pos >= rp.expect_num ||
+        rp.expect[rp.expect_pos].idx != idx || rp.expect[rp.expect_pos].evt != (uint8_t)evt)
+    {
+        replay_fail("event differs from the recorded trace");
+    }
+    rp.expect_pos++;
+
+    len = snprintf(line, sizeof(line), "%u %u 0x%04X %s\n", (unsigned)rp.time_ms, idx, key_id,
+                   kb_trace_evt_name((uint8_t)evt));
+    if (rp.out != NULL)
+    {
+        fwrite(line, 1u, (size_t)len, rp.out);
+    }
+    if (rp.golden != NULL && rp.mismatch == 0)
+    {
+        if (fread(ref, 1u, (size_t)len, rp.golden) != (size_t)len || memcmp(ref, line, (size_t)len) != 0)
+        {
+            replay_fail("event stream differs from golden file");
+        }
+    }
+    rp.out_bytes += (unsigned long)len;
+}
+
+static void replay_poll(keyboard_control_t *ctl, uint32_t dt_ms)
+{
+    rp.time_ms += dt_ms;
+    keyboard_poll(ctl, dt_ms);
+    if (rp.expect_pos != rp.expect_num)
+    {
+        replay_fail("recorded event was not reproduced");
+    }
+    rp.expect_num = 0u;
+    rp.expect_pos = 0u;
+}
+
+/* 比较 dump 头中录制端的一个时间参数，不一致时说明需要的编译选项 */
+static int replay_check_ms(const char *path, const char *name, uint32_t dump_ms, uint32_t build_ms)
+{
+    if (dump_ms == build_ms)
+    {
+        return 0;
+    }
+    fprintf(stderr, "%s: recorded with %s=%u, this build has %u; rebuild with -D%s=%uu\n",
+            path, name, (unsigned)dump_ms, (unsigned)build_ms, name, (unsigned)dump_ms);
+    return 1;
+}
+
+/* 初始状态和录制端配置与本次编译一致时返回 0，否则逐项报告 */
+static int replay_check_dump(const char *path, const kb_trace_reader_t *rd)
+{
+    int bad = 0;
+
+    if ((rd->flags & KB_TRACE_FLAG_WRAPPED) != 0u)
+    {
+        fprintf(stderr, "%s: trace wrapped, initial key state is unknown\n", path);
+        return 1;
+    }
+    if ((rd->flags & KB_TRACE_FLAG_FROM_INIT) == 0u)
+    {
+        fprintf(stderr, "%s: trace started after the first keyboard_poll() or was cleared, "
+                "initial key state is unknown\n", path);
+        return 1;
+    }
+    if (rd->features != KB_TRACE_FEATURES)
+    {
+        fprintf(stderr, "%s: recorded with event detection 0x%02X (click/double/long/repeat = bit0..3), "
+                "this build has 0x%02X; rebuild with matching KB_USING_CLICK/DOUBLE_CLICK/LONGPRESS/REPEAT\n",
+                path, rd->features, KB_TRACE_FEATURES);
+        bad = 1;
+    }
+    bad |= replay_check_ms(path, "KB_DEBOUNCE_MS", rd->debounce_ms, KB_DEBOUNCE_MS);
+    bad |= replay_check_ms(path, "KB_LONGPRESS_MS", rd->longpress_ms, KB_LONGPRESS_MS);
+    bad |= replay_check_ms(path, "KB_REPEAT_START_MS", rd->repeat_start_ms, KB_REPEAT_START_MS);
+    bad |= replay_check_ms(path, "KB_REPEAT_PERIOD_MS", rd->repeat_period_ms, KB_REPEAT_PERIOD_MS);
+    bad |= replay_check_ms(path, "KB_DOUBLE_CLICK_MS", rd->double_click_ms, KB_DOUBLE_CLICK_MS);
+
+    return bad;
+}
+
+int main(int argc, char **argv)
+{
+    keyboard_control_t ctl;
+    keyboard_ops_t ops;
+    keyboard_cb_t cb;
+    kb_trace_rec_t rec;
+    const char *path = NULL;
+    const char *out_path = NULL;
+    const char *golden_path = NULL;
+    uint32_t pending_dt = 0u;
+    FILE *fp;
+    uint16_t i;
+    int ret;
+    int k;
+
+    for (k = 1; k < argc; k++)
+    {
+        if (strcmp(argv[k], "-o") == 0 && k + 1 < argc)
+        {
+            out_path = argv[++k];
+        }
+        else if (strcmp(argv[k], "-g") == 0 && k + 1 < argc)
+        {
+            golden_path = argv[++k];
+        }
+        else
+        {
+            path = argv[k];
+        }
+    }
+    if (path == NULL)
+    {
+        fprintf(stderr, "usage: %s <dump.bin> [-o events.txt] [-g golden.txt]\n", argv[0]);
+        return 2;
+    }
+
+    fp = fopen(path, "rb");
+    if (fp == NULL || kb_trace_reader_open(&rp.rd, fp) != 0)
+    {
+        fprintf(stderr, "%s: not a keyboard trace dump\n", path);
+        return 2;
+    }
+    if (replay_check_dump(path, &rp.rd) != 0)
+    {
+        return 2;
+    }
+    if (rp.rd.key_num > KB_MAX_KEYS)
+    {
+        fprintf(stderr, "%s: %u keys, rebuild with KB_MAX_KEYS >= %u\n", path, rp.rd.key_num, rp.rd.key_num);
+        return 2;
+    }
+    if (out_path != NULL && (rp.out = fopen(out_path, "wb")) == NULL)
+    {
+        perror(out_path);
+        return 2;
+    }
+    if (golden_path != NULL && (rp.golden = fopen(golden_path, "rb")) == NULL)
+    {
+        perror(golden_path);
+        return 2;
+    }
+
+    memset(&ops, 0, sizeof(ops));
+    ops.scan_snapshot = replay_snapshot;
+    cb.on_event = replay_on_event;
+    cb.user = NULL;
+    if (keyboard_init(&ctl, &ops, &cb) != KB_OK)
+    {
+        return 2;
+    }
+    for (i = 0u; i < rp.rd.key_num; i++)
+    {
+        keyboard_key_cfg_t cfg;
+
+        memset(&cfg, 0, sizeof(cfg));
+        snprintf(rp.names[i], sizeof(rp.names[i]), "K%u", i);
+        cfg.keyname = rp.names[i];
+        cfg.key_id = rp.rd.key_ids[i];
+        cfg.hw.hw_code = i;
+#if KB_USING_HYBRID
+        cfg.backend = KB_BACKEND_CUSTOM;
+#endif
+        if (keyboard_register_key(&cfg, &ctl) != KB_OK)
+        {
+            fprintf(stderr, "register key %u failed, check KEYBOARD_POOL_SIZE\n", i);
+            return 2;
+        }
+    }
+
+    /* 一条 POLL 记录之后的 RAW/EVT 属于该记录的最后一次 poll */
+    while ((ret = kb_trace_reader_next(&rp.rd, &rec)) > 0)
+    {
+        switch (rec.type)
+        {
+        case KB_TRACE_REC_POLL:
+            if (pending_dt != 0u)
+            {
+                replay_poll(&ctl, pending_dt);
+            }
+            for (k = 1; k < rec.arg; k++)
+            {
+                replay_poll(&ctl, rec.value);
+            }
+            pending_dt = rec.value;
+            break;
+        case KB_TRACE_REC_RAW:
+            rp.raw[rec.value] = rec.arg;
+            break;
+        default:
+            if (rp.expect_num < REPLAY_EXPECT_MAX)
+            {
+                rp.expect[rp.expect_num].idx = (uint16_t)rec.value;
+                rp.expect[rp.expect_num].evt = rec.arg;
+                rp.expect_num++;
+            }
+            break;
+        }
+    }
+    if (pending_dt != 0u)
+    {
+        replay_poll(&ctl, pending_dt);
+    }
+
+    if (ret < 0)
+    {
+        fprintf(stderr, "%s: corrupted record at byte %u\n", path, (unsigned)rp.rd.data_pos);
+        return 2;
+    }
+    if (rp.golden != NULL && rp.mismatch == 0 && fgetc(rp.golden) != EOF)
+    {
+        replay_fail("golden file has more events");
+    }
+
+    kb_trace_reader_close(&rp.rd);
+    fclose(fp);
+    if (rp.out != NULL)
+    {
+        fclose(rp.out);
+    }
+    if (rp.golden != NULL)
+    {
+        fclose(rp.golden);
+    }
+
+    printf("%s: %lu bytes of events, %s\n", path, rp.out_bytes, rp.mismatch ? "MISMATCH" : "ok");
+    return rp.mismatch ? 1 : 0;
+}
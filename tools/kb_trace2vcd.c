@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+
+/*
+ * trace dump 转 VCD：回放 dump 中的原始电平，导出每个按键的 raw/stable/计时器/事件 波形，
+ * 可用 GTKWave 等波形工具查看。
+ *
+ * 用法: kb_trace2vcd <dump.bin> <out.vcd>
+ *
+ * 需要以 KB_BACKEND_MODE=KB_BACKEND_CUSTOM 编译。仿真测试台可直接使用 kb_vcd.h 的接口。
+ */
+#include <stdio.h>
+#include <string.h>
+#include "keyboard_driver.h"
+#include "kb_trace_reader.h"
+#include "kb_vcd.h"
+
+#if (KB_BACKEND_MODE != KB_BACKEND_CUSTOM)
+#error "kb_trace2vcd must be built with KB_BACKEND_MODE=KB_BACKEND_CUSTOM"
+#endif
+
+static kb_trace_reader_t rd;
+static kb_vcd_t vcd;
+static uint8_t raw[KB_MAX_KEYS];
+static char key_name[KB_MAX_KEYS][8];
+static uint32_t time_ms;
+
+static int t2v_snapshot(uint8_t *state_buf, uint16_t key_count)
+{
+    memcpy(state_buf, raw, key_count);
+    return 0;
+}
+
+static void t2v_on_event(const char *keyname, uint16_t key_id, kb_event_t evt, void *user)
+{
+    uint16_t idx = 0u;
+
+    (void)keyname;
+    (void)user;
+
+    /* 按 dump 中的 key_id 表还原按键索引（与注册顺序一致） */
+    while (idx < rd.key_num && rd.key_ids[idx] != key_id)
+    {
+        idx++;
+    }
+    if (idx < rd.key_num)
+    {
+        kb_vcd_event(&vcd, idx, evt, time_ms);
+    }
+}
+
+static void t2v_poll(keyboard_control_t *ctl, uint32_t dt_ms)
+{
+    time_ms += dt_ms;
+    keyboard_poll(ctl, dt_ms);
+    kb_vcd_sample(&vcd, ctl, time_ms);
+}
+
+int main(int argc, char **argv)
+{
+    keyboard_control_t ctl;
+    keyboard_ops_t ops;
+    keyboard_cb_t cb;
+    kb_trace_rec_t rec;
+    uint32_t pending_dt = 0u;
+    FILE *fp;
+    FILE *out;
+    uint16_t i;
+    int ret;
+    int k;
+
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s <dump.bin> <out.vcd>\n", argv[0]);
+        return 2;
+    }
+
+    fp = fopen(argv[1], "rb");
+    if (fp == NULL || kb_trace_reader_open(&rd, fp) != 0)
+    {
+        fprintf(stderr, "%s: not a keyboard trace dump\n", argv[1]);
+        return 2;
+    }
+    if (rd.key_num > KB_MAX_KEYS)
+    {
+        fprintf(stderr, "%s: %u keys, rebuild with KB_MAX_KEYS >= %u\n", argv[1], rd.key_num, rd.key_num);
+        return 2;
+    }
+    if ((rd.flags & KB_TRACE_FLAG_WRAPPED) != 0u)
+    {
+        fprintf(stderr, "%s: warning: trace wrapped, waveform starts from an unknown state\n", argv[1]);
+    }
+    out = fopen(argv[2], "w");
+    if (out == NULL || kb_vcd_open(&vcd, out, rd.key_num, NULL, rd.key_ids) != 0)
+    {
+        perror(argv[2]);
+        return 2;
+    }
+
+    memset(&ops, 0, sizeof(ops));
+    ops.scan_snapshot = t2v_snapshot;
+    cb.on_event = t2v_on_event;
+    cb.user = NULL;
+    if (keyboard_init(&ctl, &ops, &cb) != KB_OK)
+    {
+        return 2;
+    }
+    for (i = 0u; i < rd.key_num; i++)
+    {
+        keyboard_key_cfg_t cfg;
+
+        memset(&cfg, 0, sizeof(cfg));
+        snprintf(key_name[i], sizeof(key_name[i]), "K%u", i);
+        cfg.keyname = key_name[i];
+        cfg.key_id = rd.key_ids[i];
+        cfg.hw.hw_code = i;
+#if KB_USING_HYBRID
+        cfg.backend = KB_BACKEND_CUSTOM;
+#endif
+        if (keyboard_register_key(&cfg, &ctl) != KB_OK)
+        {
+            fprintf(stderr, "register key %u failed, check KEYBOARD_POOL_SIZE\n", i);
+            return 2;
+        }
+    }
+
+    time_ms = rd.base_time_ms;
+    while ((ret = kb_trace_reader_next(&rd, &rec)) > 0)
+    {
+        if (rec.type == KB_TRACE_REC_POLL)
+        {
+            if (pending_dt != 0u)
+            {
+                t2v_poll(&ctl, pending_dt);
+            }
+            for (k = 1; k < rec.arg; k++)
+            {
+                t2v_poll(&ctl, rec.value);
+            }
+            pending_dt = rec.value;
+        }
+        else if (rec.type == KB_TRACE_REC_RAW)
+        {
+            raw[rec.value] = rec.arg;
+        }
+    }
+    if (pending_dt != 0u)
+    {
+        t2v_poll(&ctl, pending_dt);
+    }
+
+    kb_vcd_close(&vcd);
+    kb_trace_reader_close(&rd);
+    fclose(out);
+    fclose(fp);
+
+    if (ret < 0)
+    {
+        fprintf(stderr, "%s: corrupted record at byte %u\n", argv[1], (unsigned)rd.data_pos);
+        return 1;
+    }
+    return 0;
+}
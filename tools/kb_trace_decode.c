@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+
+/*
+ * trace dump 解码器：把串口导出的二进制 dump 还原成时间线
+ *
+ * 用法: kb_trace_decode [-a] <dump.bin>
+ *   -a  同时打印空闲 poll 记录
+ */
+#include <stdio.h>
+#include <string.h>
+#include "kb_trace_reader.h"
+
+int main(int argc, char **argv)
+{
+    kb_trace_reader_t rd;
+    kb_trace_rec_t rec;
+    const char *path = NULL;
+    int show_poll = 0;
+    int ret;
+    int i;
+    FILE *fp;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-a") == 0)
+        {
+            show_poll = 1;
+        }
+        else
+        {
+            path = argv[i];
+        }
+    }
+    if (path == NULL)
+    {
+        fprintf(stderr, "usage: %s [-a] <dump.bin>\n", argv[0]);
+        return 2;
+    }
+
+    fp = fopen(path, "rb");
+    if (fp == NULL || kb_trace_reader_open(&rd, fp) != 0)
+    {
+        fprintf(stderr, "%s: not a keyboard trace dump\n", path);
+        return 1;
+    }
+
+    printf("# keys=%u bytes=%u%s%s\n", rd.key_num, (unsigned)rd.data_len,
+           (rd.flags & KB_TRACE_FLAG_WRAPPED) ? " wrapped (oldest records dropped)" : "",
+           (rd.flags & KB_TRACE_FLAG_FROM_INIT) ? " from-init" : "");
+    printf("# features=0x%02X debounce=%u longpress=%u repeat=%u/%u double_click=%u ms\n", rd.features,
+           (unsigned)rd.debounce_ms, (unsigned)rd.longpress_ms, (unsigned)rd.repeat_start_ms,
+           (unsigned)rd.repeat_period_ms, (unsigned)rd.double_click_ms);
+    printf("%10s %5s %7s  %s\n", "time_ms", "idx", "key_id", "record");
+
+    while ((ret = kb_trace_reader_next(&rd, &rec)) > 0)
+    {
+        switch (rec.type)
+        {
+        case KB_TRACE_REC_POLL:
+            if (show_poll)
+            {
+                printf("%10u %5s %7s  POLL dt=%u x%u\n", (unsigned)rec.time_ms, "-", "-",
+                       (unsigned)rec.value, rec.arg);
+            }
+            break;
+        case KB_TRACE_REC_RAW:
+            printf("%10u %5u  0x%04X  RAW %u\n", (unsigned)rec.time_ms, (unsigned)rec.value,
+                   rd.key_ids[rec.value], rec.arg);
+            break;
+        default:
+            printf("%10u %5u  0x%04X  %s\n", (unsigned)rec.time_ms, (unsigned)rec.value,
+                   rd.key_ids[rec.value], kb_trace_evt_name(rec.arg));
+            break;
+        }
+    }
+
+    kb_trace_reader_close(&rd);
+    fclose(fp);
+
+    if (ret < 0)
+    {
+        fprintf(stderr, "%s: corrupted record at byte %u\n", path, (unsigned)rd.data_pos);
+        return 1;
+    }
+    return 0;
+}
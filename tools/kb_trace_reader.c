@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "kb_trace_reader.h"
+
+static int kb_reader_getc(kb_trace_reader_t *rd)
+{
+    int c;
+
+    if (rd->data_pos >= rd->data_len)
+    {
+        return EOF;
+    }
+    c = fgetc(rd->fp);
+    if (c != EOF)
+    {
+        rd->data_pos++;
+    }
+    return c;
+}
+
+static uint32_t kb_reader_le(const uint8_t *p, uint8_t n)
+{
+    uint32_t v = 0u;
+    uint8_t i;
+
+    for (i = 0u; i < n; i++)
+    {
+        v |= (uint32_t)p[i] << (8u * i);
+    }
+    return v;
+}
+
+int kb_trace_reader_open(kb_trace_reader_t *rd, FILE *fp)
+{
+    uint8_t hdr[KB_TRACE_HDR_LEN];
+    uint8_t id_buf[2];
+    uint16_t i;
+
+    if (rd == NULL || fp == NULL)
+    {
+        return -1;
+    }
+    memset(rd, 0, sizeof(*rd));
+    rd->fp = fp;
+
+    if (fread(hdr, 1u, sizeof(hdr), fp) != sizeof(hdr) || memcmp(hdr, KB_TRACE_MAGIC, 4u) != 0)
+    {
+        return -1;
+    }
+    rd->flags = hdr[4];
+    rd->key_num = (uint16_t)kb_reader_le(&hdr[5], 2u);
+    rd->base_dt = kb_reader_le(&hdr[7], 4u);
+    rd->base_time_ms = kb_reader_le(&hdr[11], 4u);
+    rd->data_len = kb_reader_le(&hdr[15], 4u);
+    rd->features = hdr[19];
+    rd->debounce_ms = kb_reader_le(&hdr[20], 4u);
+    rd->longpress_ms = kb_reader_le(&hdr[24], 4u);
+    rd->repeat_start_ms = kb_reader_le(&hdr[28], 4u);
+    rd->repeat_period_ms = kb_reader_le(&hdr[32], 4u);
+    rd->double_click_ms = kb_reader_le(&hdr[36], 4u);
+    rd->dt = rd->base_dt;
+    rd->time_ms = rd->base_time_ms;
+
+    rd->key_ids = (uint16_t *)calloc(rd->key_num ? rd->key_num : 1u, sizeof(uint16_t));
+    if (rd->key_ids == NULL)
+    {
+        return -1;
+    }
+    for (i = 0u; i < rd->key_num; i++)
+    {
+        if (fread(id_buf, 1u, 2u, fp) != 2u)
+        {
+            return -1;
+        }
+        rd->key_ids[i] = (uint16_t)kb_reader_le(id_buf, 2u);
+    }
+
+    return 0;
+}
+
+int kb_trace_reader_next(kb_trace_reader_t *rd, kb_trace_rec_t *rec)
+{
+    int c;
+    uint32_t value = 0u;
+    uint8_t shift = 0u;
+    uint8_t tag;
+
+    c = kb_reader_getc(rd);
+    if (c == EOF)
+    {
+        return (rd->data_pos >= rd->data_len) ? 0 : -1;
+    }
+    tag = (uint8_t)c;
+    rec->type = (uint8_t)(tag >> 4);
+    rec->arg = (uint8_t)(tag & 0x0Fu);
+
+    if (rec->type == KB_TRACE_REC_POLL && rec->arg != 0u)
+    {
+        rec->value = rd->dt;
+        rd->time_ms += rd->dt * rec->arg;
+        rec->time_ms = rd->time_ms;
+        return 1;
+    }
+
+    do
+    {
+        c = kb_reader_getc(rd);
+        if (c == EOF || shift >= 35u)
+        {
+            return -1;
+        }
+        value |= (uint32_t)(c & 0x7F) << shift;
+        shift = (uint8_t)(shift + 7u);
+    } while ((c & 0x80) != 0);
+    rec->value = value;
+
+    switch (rec->type)
+    {
+    case KB_TRACE_REC_POLL:
+        rec->arg = 1u;
+        rd->dt = value;
+        rd->time_ms += value;
+        break;
+    case KB_TRACE_REC_RAW:
+    case KB_TRACE_REC_EVT:
+        if (value >= rd->key_num)
+        {
+            return -1;
+        }
+        break;
+    default:
+        return -1;
+    }
+    rec->time_ms = rd->time_ms;
+
+    return 1;
+}
+
+void kb_trace_reader_close(kb_trace_reader_t *rd)
+{
+    if (rd != NULL)
+    {
+        free(rd->key_ids);
+        rd->key_ids = NULL;
+    }
+}
+
+const char *kb_trace_evt_name(uint8_t evt)
+{
+    static const char *const names[] = {
+        "PRESS", "RELEASE", "CLICK", "LONGPRESS", "LONGPRESS_RELEASE", "REPEAT", "DOUBLE_CLICK"
+    };
+
+    if (evt < sizeof(names) / sizeof(names[0]))
+    {
+        return names[evt];
+    }
+    return "UNKNOWN";
+}
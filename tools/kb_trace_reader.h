@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+#ifndef MYCOMPONENTS_KEYBOARD_TOOLS_KB_TRACE_READER_H_
+#define MYCOMPONENTS_KEYBOARD_TOOLS_KB_TRACE_READER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include "keyboard_trace.h"
+
+/* 主机侧 trace dump 读取器：流式逐条解析，不需要把整个文件读进内存 */
+typedef struct
+{
+    FILE *fp;
+    uint8_t flags;
+    uint16_t key_num;
+    uint32_t base_dt;
+    uint32_t base_time_ms;
+    uint32_t data_len;
+    uint8_t features;     /* 录制端的 KB_TRACE_FEATURES */
+    uint32_t debounce_ms;
+    uint32_t longpress_ms;
+    uint32_t repeat_start_ms;
+    uint32_t repeat_period_ms;
+    uint32_t double_click_ms;
+    uint32_t data_pos;
+    uint16_t *key_ids;
+    uint32_t dt;          /* 当前生效的 dt */
+    uint32_t time_ms;     /* 最近一次 poll 的时间 */
+} kb_trace_reader_t;
+
+typedef struct
+{
+    uint8_t type;         /* KB_TRACE_REC_* */
+    uint8_t arg;          /* POLL: poll 次数；RAW: 电平；EVT: kb_event_t */
+    uint32_t value;       /* POLL: dt_ms；RAW/EVT: 按键索引 */
+    uint32_t time_ms;     /* 记录所属 poll 的时间 */
+} kb_trace_rec_t;
+
+/* 读取并校验文件头，成功返回 0 */
+int kb_trace_reader_open(kb_trace_reader_t *rd, FILE *fp);
+
+/* 读取下一条记录：1 表示读到记录，0 表示结束，<0 表示数据损坏 */
+int kb_trace_reader_next(kb_trace_reader_t *rd, kb_trace_rec_t *rec);
+
+void kb_trace_reader_close(kb_trace_reader_t *rd);
+
+const char *kb_trace_evt_name(uint8_t evt);
+
+#endif /* MYCOMPONENTS_KEYBOARD_TOOLS_KB_TRACE_READER_H_ */
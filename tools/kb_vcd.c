@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "kb_vcd.h"
+
+static const char *const kb_vcd_sig_name[KB_VCD_SIG_NUM] = {
+    "raw", "stable", "debounce_ms", "press_ms", "repeat_ms", "click_wait_ms", "event"
+};
+
+static const uint8_t kb_vcd_sig_width[KB_VCD_SIG_NUM] = {
+    1u, 1u, 32u, 32u, 32u, 32u, 8u
+};
+
+/* VCD 标识符：可打印字符 '!'..'~' 组成的 94 进制编码 */
+static void kb_vcd_id(char *buf, uint32_t n)
+{
+    uint8_t len = 0u;
+
+    do
+    {
+        buf[len++] = (char)('!' + (n % 94u));
+        n /= 94u;
+    } while (n != 0u);
+    buf[len] = '\0';
+}
+
+static void kb_vcd_time(kb_vcd_t *vcd, uint32_t time_ms)
+{
+    if (vcd->time_written == 0u || time_ms != vcd->time_ms)
+    {
+        fprintf(vcd->fp, "#%u\n", (unsigned)time_ms);
+        vcd->time_ms = time_ms;
+        vcd->time_written = 1u;
+    }
+}
+
+static void kb_vcd_put(kb_vcd_t *vcd, uint32_t sig, uint32_t value)
+{
+    char id[8];
+    char bits[33];
+    uint8_t width = kb_vcd_sig_width[sig % KB_VCD_SIG_NUM];
+    int8_t i;
+    uint8_t n = 0u;
+
+    kb_vcd_id(id, sig);
+    if (width == 1u)
+    {
+        fprintf(vcd->fp, "%u%s\n", (unsigned)(value & 1u), id);
+        return;
+    }
+
+    for (i = 31; i > 0 && ((value >> i) & 1u) == 0u; i--)
+    {
+    }
+    for (; i >= 0; i--)
+    {
+        bits[n++] = (char)('0' + ((value >> i) & 1u));
+    }
+    bits[n] = '\0';
+    fprintf(vcd->fp, "b%s %s\n", bits, id);
+}
+
+static void kb_vcd_update(kb_vcd_t *vcd, uint32_t sig, uint32_t value, uint32_t time_ms)
+{
+    if (vcd->last[sig] != value)
+    {
+        kb_vcd_time(vcd, time_ms);
+        vcd->last[sig] = value;
+        kb_vcd_put(vcd, sig, value);
+    }
+}
+
+/* 事件是瞬时信号：保持到下一个时刻后复位 */
+static void kb_vcd_clear_events(kb_vcd_t *vcd, uint32_t time_ms)
+{
+    uint16_t k;
+
+    if (vcd->evt_dirty == 0u || time_ms == vcd->evt_time_ms)
+    {
+        return;
+    }
+    for (k = 0u; k < vcd->key_num; k++)
+    {
+        kb_vcd_update(vcd, (uint32_t)k * KB_VCD_SIG_NUM + KB_VCD_SIG_EVENT, 0u, time_ms);
+    }
+    vcd->evt_dirty = 0u;
+}
+
+int kb_vcd_open(kb_vcd_t *vcd, FILE *fp, uint16_t key_num, const char *const *keynames, const uint16_t *key_ids)
+{
+    uint32_t sig;
+    uint16_t k;
+    uint8_t s;
+    char id[8];
+
+    if (vcd == NULL || fp == NULL)
+    {
+        return -1;
+    }
+    memset(vcd, 0, sizeof(*vcd));
+    vcd->fp = fp;
+    vcd->key_num = key_num;
+    vcd->last = (uint32_t *)calloc((size_t)key_num * KB_VCD_SIG_NUM + 1u, sizeof(uint32_t));
+    if (vcd->last == NULL)
+    {
+        return -1;
+    }
+
+    fprintf(fp, "$version keyboard kb_vcd $end\n");
+    fprintf(fp, "$timescale 1ms $end\n");
+    fprintf(fp, "$scope module keyboard $end\n");
+    for (k = 0u; k < key_num; k++)
+    {
+        if (keynames != NULL && keynames[k] != NULL)
+        {
+            fprintf(fp, "$scope module %s $end\n", keynames[k]);
+        }
+        else
+        {
+            fprintf(fp, "$scope module K%u_0x%04X $end\n", k, key_ids != NULL ? key_ids[k] : k);
+        }
+        for (s = 0u; s < KB_VCD_SIG_NUM; s++)
+        {
+            kb_vcd_id(id, (uint32_t)k * KB_VCD_SIG_NUM + s);
+            fprintf(fp, "$var %s %u %s %s $end\n", (kb_vcd_sig_width[s] == 1u) ? "wire" : "integer",
+                    kb_vcd_sig_width[s], id, kb_vcd_sig_name[s]);
+        }
+        fprintf(fp, "$upscope $end\n");
+    }
+    fprintf(fp, "$upscope $end\n");
+    fprintf(fp, "$enddefinitions $end\n");
+
+    fprintf(fp, "#0\n$dumpvars\n");
+    for (sig = 0u; sig < (uint32_t)key_num * KB_VCD_SIG_NUM; sig++)
+    {
+        kb_vcd_put(vcd, sig, 0u);
+    }
+    fprintf(fp, "$end\n");
+    vcd->time_written = 1u;
+
+    return 0;
+}
+
+void kb_vcd_sample(kb_vcd_t *vcd, const keyboard_control_t *ctl, uint32_t time_ms)
+{
+    keyboard_key_state_t st;
+    uint32_t base;
+    uint16_t k;
+
+    kb_vcd_clear_events(vcd, time_ms);
+    for (k = 0u; k < vcd->key_num; k++)
+    {
+        if (keyboard_get_key_state(ctl, k, &st) != KB_OK)
+        {
+            break;
+        }
+        base = (uint32_t)k * KB_VCD_SIG_NUM;
+        kb_vcd_update(vcd, base + KB_VCD_SIG_RAW, st.raw, time_ms);
+        kb_vcd_update(vcd, base + KB_VCD_SIG_STABLE, st.stable, time_ms);
+        kb_vcd_update(vcd, base + KB_VCD_SIG_DEBOUNCE, st.debounce_ms, time_ms);
+        kb_vcd_update(vcd, base + KB_VCD_SIG_PRESS, st.press_ms, time_ms);
+        kb_vcd_update(vcd, base + KB_VCD_SIG_REPEAT, st.repeat_ms, time_ms);
+        kb_vcd_update(vcd, base + KB_VCD_SIG_CLICK_WAIT, st.click_wait_ms, time_ms);
+    }
+}
+
+void kb_vcd_event(kb_vcd_t *vcd, uint16_t idx, kb_event_t evt, uint32_t time_ms)
+{
+    uint32_t sig;
+
+    if (idx >= vcd->key_num)
+    {
+        return;
+    }
+    kb_vcd_clear_events(vcd, time_ms);
+    sig = (uint32_t)idx * KB_VCD_SIG_NUM + KB_VCD_SIG_EVENT;
+    kb_vcd_time(vcd, time_ms);
+    vcd->last[sig] = (uint32_t)evt + 1u;
+    kb_vcd_put(vcd, sig, vcd->last[sig]);
+    vcd->evt_time_ms = time_ms;
+    vcd->evt_dirty = 1u;
+}
+
+void kb_vcd_close(kb_vcd_t *vcd)
+{
+    if (vcd == NULL)
+    {
+        return;
+    }
+    fflush(vcd->fp);
+    free(vcd->last);
+    vcd->last = NULL;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2006-2021
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     wsoz         the first version
+ */
+#ifndef MYCOMPONENTS_KEYBOARD_TOOLS_KB_VCD_H_
+#define MYCOMPONENTS_KEYBOARD_TOOLS_KB_VCD_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include "keyboard_driver.h"
+
+/*
+ * VCD 波形导出：每个按键导出 raw/stable/各计时器/事件 信号。
+ * 只保存每个信号的上一次取值，边采样边写文件，长时间大键盘采集也不占内存。
+ *
+ * 用法：kb_vcd_open() 后，每次 keyboard_poll() 结束调用 kb_vcd_sample()，
+ * 事件回调里调用 kb_vcd_event()，最后 kb_vcd_close()。
+ */
+#define KB_VCD_SIG_RAW          0u
+#define KB_VCD_SIG_STABLE       1u
+#define KB_VCD_SIG_DEBOUNCE     2u
+#define KB_VCD_SIG_PRESS        3u
+#define KB_VCD_SIG_REPEAT       4u
+#define KB_VCD_SIG_CLICK_WAIT   5u
+#define KB_VCD_SIG_EVENT        6u
+#define KB_VCD_SIG_NUM          7u
+
+typedef struct
+{
+    FILE *fp;
+    uint16_t key_num;
+    uint32_t *last;          /* key_num * KB_VCD_SIG_NUM 个信号的上一次取值 */
+    uint32_t time_ms;        /* 最近一次写出的时间 */
+    uint8_t time_written;
+    uint32_t evt_time_ms;    /* 最近一次事件的时间 */
+    uint8_t evt_dirty;       /* 有事件信号需要在之后的时刻复位 */
+} kb_vcd_t;
+
+/* 写 VCD 头并声明信号，keynames 可以为 NULL（使用 K<idx>） */
+int kb_vcd_open(kb_vcd_t *vcd, FILE *fp, uint16_t key_num, const char *const *keynames, const uint16_t *key_ids);
+
+/* 在 time_ms 时刻采样 ctl 中全部按键状态，只写出变化的信号 */
+void kb_vcd_sample(kb_vcd_t *vcd, const keyboard_control_t *ctl, uint32_t time_ms);
+
+/* 记录事件：事件信号取值为 kb_event_t + 1，之后的时刻复位为 0 */
+void kb_vcd_event(kb_vcd_t *vcd, uint16_t idx, kb_event_t evt, uint32_t time_ms);
+
+void kb_vcd_close(kb_vcd_t *vcd);
+
+#endif /* MYCOMPONENTS_KEYBOARD_TOOLS_KB_VCD_H_ */